@@ -0,0 +1,568 @@
+/**
+ * @file http_bench.cpp
+ * @brief Load-generation benchmark for the HttpClient class.
+ *
+ * Starts a loopback server that speaks HTTP/1.1 and HTTP/2 with prior knowledge
+ * (h2c) on the same port, then drives HttpClient against it with a configurable
+ * number of concurrent requests for a fixed duration. Reports throughput and
+ * latency percentiles, so changes can be measured without a public test service.
+ *
+ * Usage: http_client_bench [--mode=sync|async] [--http=1.1|2] [--concurrency=N]
+ *                          [--duration=SECONDS] [--request-size=BYTES] [--response-size=BYTES]
+ * A request size of 0 sends GET requests; anything larger sends POST bodies of that size.
+ */
+
+#include "../http_client.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::string mode = "sync";
+    std::string http = "1.1";
+    std::size_t concurrency = 16;
+    double durationSeconds = 5.0;
+    std::size_t requestSize = 0;
+    std::size_t responseSize = 1024;
+};
+
+[[nodiscard]] BenchOptions parse_options(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        const auto equals = arg.find('=');
+        if (!arg.starts_with("--") || equals == std::string_view::npos) {
+            throw std::invalid_argument("Unrecognized argument: " + std::string(arg));
+        }
+        const std::string_view key = arg.substr(2, equals - 2);
+        const std::string value(arg.substr(equals + 1));
+        if (key == "mode") options.mode = value;
+        else if (key == "http") options.http = value;
+        else if (key == "concurrency") options.concurrency = std::stoul(value);
+        else if (key == "duration") options.durationSeconds = std::stod(value);
+        else if (key == "request-size") options.requestSize = std::stoul(value);
+        else if (key == "response-size") options.responseSize = std::stoul(value);
+        else throw std::invalid_argument("Unknown option: --" + std::string(key));
+    }
+    if (options.mode != "sync" && options.mode != "async") throw std::invalid_argument("--mode must be sync or async");
+    if (options.http != "1.1" && options.http != "2") throw std::invalid_argument("--http must be 1.1 or 2");
+    if (options.concurrency == 0) throw std::invalid_argument("--concurrency must be at least 1");
+    return options;
+}
+
+// --- Socket helpers ---
+
+[[nodiscard]] bool read_exact(int fd, char* data, std::size_t length) {
+    while (length > 0) {
+        const auto received = ::recv(fd, data, length, 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) continue;
+            return false;
+        }
+        data += received;
+        length -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+[[nodiscard]] bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(sent));
+    }
+    return true;
+}
+
+// --- HTTP/1.1 ---
+
+// Serves keep-alive HTTP/1.1 requests with a fixed response. Request bodies are read and discarded.
+void serve_http1(int fd, std::string buffer, const std::string& response) {
+    static constexpr std::size_t READ_CHUNK = 64 * 1024;
+    std::array<char, READ_CHUNK> chunk{};
+    for (;;) {
+        std::size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            const auto received = ::recv(fd, chunk.data(), chunk.size(), 0);
+            if (received <= 0) return;
+            buffer.append(chunk.data(), static_cast<std::size_t>(received));
+        }
+        std::string head = buffer.substr(0, header_end);
+        std::ranges::transform(head, head.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        std::size_t body_length = 0;
+        if (const auto position = head.find("\r\ncontent-length:"); position != std::string::npos) {
+            body_length = std::stoul(head.substr(position + 17));
+        }
+        if (head.find("\r\nexpect: 100-continue") != std::string::npos && !write_all(fd, "HTTP/1.1 100 Continue\r\n\r\n")) {
+            return;
+        }
+
+        buffer.erase(0, header_end + 4);
+        const std::size_t buffered = std::min(body_length, buffer.size());
+        buffer.erase(0, buffered);
+        for (std::size_t remaining = body_length - buffered; remaining > 0;) {
+            const auto received = ::recv(fd, chunk.data(), std::min(remaining, chunk.size()), 0);
+            if (received <= 0) return;
+            remaining -= static_cast<std::size_t>(received);
+        }
+        if (!write_all(fd, response)) return;
+    }
+}
+
+// --- HTTP/2 with prior knowledge ---
+
+// A deliberately small HTTP/2 server: it never decodes request headers (responses are fixed, and it
+// keeps no HPACK state of its own), but it honours flow control in both directions so large bodies work.
+class Http2Connection {
+public:
+    Http2Connection(int fd, std::size_t responseSize) : m_fd(fd), m_body(responseSize, 'x') {}
+
+    void serve() {
+        static constexpr std::string_view PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        std::string preface(PREFACE.size(), '\0');
+        if (!read_exact(m_fd, preface.data(), preface.size()) || preface != PREFACE) return;
+
+        // Allow up to 1024 concurrent streams and open a large upload window.
+        std::string settings;
+        append_setting(settings, SETTINGS_MAX_CONCURRENT_STREAMS, 1024);
+        append_frame(m_out, FRAME_SETTINGS, 0, 0, settings);
+        append_window_update(m_out, 0, UPLOAD_WINDOW_BOOST);
+
+        std::array<char, FRAME_HEADER_SIZE> header{};
+        std::string payload;
+        while (flush() && read_exact(m_fd, header.data(), header.size())) {
+            const auto length = (static_cast<std::uint32_t>(static_cast<unsigned char>(header[0])) << 16) |
+                                (static_cast<std::uint32_t>(static_cast<unsigned char>(header[1])) << 8) |
+                                static_cast<std::uint32_t>(static_cast<unsigned char>(header[2]));
+            const auto type = static_cast<unsigned char>(header[3]);
+            const auto flags = static_cast<unsigned char>(header[4]);
+            const std::uint32_t stream = read_u32(header.data() + 5) & 0x7fffffffU;
+            payload.resize(length);
+            if (!read_exact(m_fd, payload.data(), length)) return;
+            if (!handle_frame(type, flags, stream, payload)) return;
+            send_pending();
+        }
+    }
+
+private:
+    static constexpr std::size_t FRAME_HEADER_SIZE = 9;
+    static constexpr std::size_t MAX_FRAME_SIZE = 16384;
+    static constexpr std::int64_t DEFAULT_WINDOW = 65535;
+    static constexpr std::uint32_t UPLOAD_WINDOW_BOOST = 1U << 30;
+    static constexpr unsigned char FRAME_DATA = 0x0;
+    static constexpr unsigned char FRAME_HEADERS = 0x1;
+    static constexpr unsigned char FRAME_RST_STREAM = 0x3;
+    static constexpr unsigned char FRAME_SETTINGS = 0x4;
+    static constexpr unsigned char FRAME_PING = 0x6;
+    static constexpr unsigned char FRAME_GOAWAY = 0x7;
+    static constexpr unsigned char FRAME_WINDOW_UPDATE = 0x8;
+    static constexpr unsigned char FLAG_END_STREAM = 0x1;
+    static constexpr unsigned char FLAG_ACK = 0x1;
+    static constexpr unsigned char FLAG_END_HEADERS = 0x4;
+    static constexpr std::uint16_t SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+    static constexpr std::uint16_t SETTINGS_INITIAL_WINDOW_SIZE = 0x4;
+
+    struct Stream {
+        std::int64_t window = DEFAULT_WINDOW;
+        bool requestComplete = false;
+        bool headersSent = false;
+        std::size_t bodySent = 0;
+    };
+
+    [[nodiscard]] static std::uint32_t read_u32(const char* data) {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value = (value << 8) | static_cast<unsigned char>(data[i]);
+        return value;
+    }
+
+    static void append_u32(std::string& out, std::uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+
+    static void append_frame(std::string& out, unsigned char type, unsigned char flags, std::uint32_t stream, std::string_view payload) {
+        out.push_back(static_cast<char>((payload.size() >> 16) & 0xff));
+        out.push_back(static_cast<char>((payload.size() >> 8) & 0xff));
+        out.push_back(static_cast<char>(payload.size() & 0xff));
+        out.push_back(static_cast<char>(type));
+        out.push_back(static_cast<char>(flags));
+        append_u32(out, stream);
+        out.append(payload);
+    }
+
+    static void append_setting(std::string& out, std::uint16_t id, std::uint32_t value) {
+        out.push_back(static_cast<char>(id >> 8));
+        out.push_back(static_cast<char>(id & 0xff));
+        append_u32(out, value);
+    }
+
+    static void append_window_update(std::string& out, std::uint32_t stream, std::uint32_t increment) {
+        std::string payload;
+        append_u32(payload, increment);
+        append_frame(out, FRAME_WINDOW_UPDATE, 0, stream, payload);
+    }
+
+    // ":status: 200" from the HPACK static table, then content-length as a literal with an indexed name.
+    [[nodiscard]] std::string response_header_block() const {
+        static constexpr char STATUS_200 = static_cast<char>(0x88);
+        static constexpr std::string_view CONTENT_LENGTH_NAME = "\x0f\x0d";
+        const std::string length = std::to_string(m_body.size());
+        std::string block(1, STATUS_200);
+        block.append(CONTENT_LENGTH_NAME);
+        block.push_back(static_cast<char>(length.size()));
+        block.append(length);
+        return block;
+    }
+
+    [[nodiscard]] bool handle_frame(unsigned char type, unsigned char flags, std::uint32_t stream, const std::string& payload) {
+        switch (type) {
+            case FRAME_SETTINGS:
+                if ((flags & FLAG_ACK) == 0) {
+                    for (std::size_t i = 0; i + 6 <= payload.size(); i += 6) {
+                        const auto id = static_cast<std::uint16_t>((static_cast<unsigned char>(payload[i]) << 8) | static_cast<unsigned char>(payload[i + 1]));
+                        if (id == SETTINGS_INITIAL_WINDOW_SIZE) {
+                            const auto window = static_cast<std::int64_t>(read_u32(payload.data() + i + 2));
+                            for (auto& [id_, open_stream] : m_streams) open_stream.window += window - m_initialWindow;
+                            m_initialWindow = window;
+                        }
+                    }
+                    append_frame(m_out, FRAME_SETTINGS, FLAG_ACK, 0, {});
+                }
+                return true;
+            case FRAME_PING:
+                if ((flags & FLAG_ACK) == 0) append_frame(m_out, FRAME_PING, FLAG_ACK, 0, payload);
+                return true;
+            case FRAME_WINDOW_UPDATE: {
+                const auto increment = static_cast<std::int64_t>(read_u32(payload.data()) & 0x7fffffffU);
+                if (stream == 0) {
+                    m_connectionWindow += increment;
+                } else if (auto it = m_streams.find(stream); it != m_streams.end()) {
+                    it->second.window += increment;
+                }
+                return true;
+            }
+            case FRAME_HEADERS:
+                m_streams.try_emplace(stream, Stream{.window = m_initialWindow});
+                if (flags & FLAG_END_STREAM) m_streams[stream].requestComplete = true;
+                return true;
+            case FRAME_DATA:
+                if (!payload.empty()) {
+                    append_window_update(m_out, 0, static_cast<std::uint32_t>(payload.size()));
+                    if ((flags & FLAG_END_STREAM) == 0) append_window_update(m_out, stream, static_cast<std::uint32_t>(payload.size()));
+                }
+                if (flags & FLAG_END_STREAM) {
+                    if (auto it = m_streams.find(stream); it != m_streams.end()) it->second.requestComplete = true;
+                }
+                return true;
+            case FRAME_RST_STREAM:
+                m_streams.erase(stream);
+                return true;
+            case FRAME_GOAWAY:
+                return false;
+            default:
+                // PRIORITY, CONTINUATION and unknown frames need no action here.
+                return true;
+        }
+    }
+
+    // Queues response frames for every completed request, as far as the flow-control windows allow.
+    void send_pending() {
+        for (auto it = m_streams.begin(); it != m_streams.end();) {
+            Stream& stream = it->second;
+            if (!stream.requestComplete) {
+                ++it;
+                continue;
+            }
+            if (!stream.headersSent) {
+                append_frame(m_out, FRAME_HEADERS, m_body.empty() ? FLAG_END_HEADERS | FLAG_END_STREAM : FLAG_END_HEADERS, it->first, response_header_block());
+                stream.headersSent = true;
+            }
+            while (stream.bodySent < m_body.size() && stream.window > 0 && m_connectionWindow > 0) {
+                const auto allowed = static_cast<std::size_t>(std::min({stream.window, m_connectionWindow, static_cast<std::int64_t>(MAX_FRAME_SIZE)}));
+                const std::size_t length = std::min(allowed, m_body.size() - stream.bodySent);
+                const bool last = stream.bodySent + length == m_body.size();
+                append_frame(m_out, FRAME_DATA, last ? FLAG_END_STREAM : 0, it->first, std::string_view(m_body).substr(stream.bodySent, length));
+                stream.bodySent += length;
+                stream.window -= static_cast<std::int64_t>(length);
+                m_connectionWindow -= static_cast<std::int64_t>(length);
+            }
+            if (stream.bodySent == m_body.size()) {
+                it = m_streams.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    [[nodiscard]] bool flush() {
+        const bool written = write_all(m_fd, m_out);
+        m_out.clear();
+        return written;
+    }
+
+    int m_fd;
+    std::string m_body;
+    std::string m_out;
+    std::map<std::uint32_t, Stream> m_streams;
+    std::int64_t m_initialWindow = DEFAULT_WINDOW;
+    std::int64_t m_connectionWindow = DEFAULT_WINDOW;
+};
+
+// --- Loopback server ---
+
+// Accepts connections on 127.0.0.1 and serves each on its own thread. The protocol is detected
+// from the first bytes, so one port serves both HTTP/1.1 and h2c clients.
+class LoopbackServer {
+public:
+    explicit LoopbackServer(std::size_t responseSize)
+        : m_responseSize(responseSize),
+          m_http1Response("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(responseSize) + "\r\n\r\n" + std::string(responseSize, 'x')) {
+        m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listenFd < 0) throw std::runtime_error("socket() failed");
+        const int enable = 1;
+        ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listenFd, SOMAXCONN) != 0) {
+            ::close(m_listenFd);
+            throw std::runtime_error("bind() or listen() failed");
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+        m_acceptThread = std::jthread([this] { accept_loop(); });
+    }
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    ~LoopbackServer() {
+        m_stopping = true;
+        ::shutdown(m_listenFd, SHUT_RDWR);
+        m_acceptThread.join();
+        ::close(m_listenFd);
+        std::scoped_lock lock(m_mutex);
+        for (const int fd : m_connections) ::shutdown(fd, SHUT_RDWR);
+        for (auto& thread : m_threads) thread.join();
+    }
+
+    [[nodiscard]] std::uint16_t port() const noexcept { return m_port; }
+
+private:
+    void accept_loop() {
+        while (!m_stopping) {
+            const int fd = ::accept(m_listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (m_stopping) return;
+                continue;
+            }
+            const int enable = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            std::scoped_lock lock(m_mutex);
+            m_connections.push_back(fd);
+            m_threads.emplace_back([this, fd] {
+                serve(fd);
+                ::close(fd);
+            });
+        }
+    }
+
+    void serve(int fd) const {
+        static constexpr std::string_view H2_PREFIX = "PRI * HTTP/2.0";
+        std::string initial(H2_PREFIX.size(), '\0');
+        const auto peeked = ::recv(fd, initial.data(), initial.size(), MSG_PEEK | MSG_WAITALL);
+        if (peeked <= 0) return;
+        initial.resize(static_cast<std::size_t>(peeked));
+        if (initial == H2_PREFIX) {
+            Http2Connection(fd, m_responseSize).serve();
+        } else {
+            serve_http1(fd, {}, m_http1Response);
+        }
+    }
+
+    std::size_t m_responseSize;
+    std::string m_http1Response;
+    int m_listenFd = -1;
+    std::uint16_t m_port = 0;
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_mutex;
+    std::vector<int> m_connections;
+    std::vector<std::jthread> m_threads;
+    std::jthread m_acceptThread;
+};
+
+// --- Load generation ---
+
+struct BenchResult {
+    std::vector<std::uint32_t> latenciesMicros;
+    std::size_t errors = 0;
+    std::string firstError;
+    std::size_t bytesReceived = 0;
+    double elapsedSeconds = 0;
+};
+
+[[nodiscard]] std::uint32_t elapsed_micros(Clock::time_point start) {
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+// Each thread issues blocking requests back to back until the deadline.
+[[nodiscard]] BenchResult run_sync(const HttpClient& client, const std::string& url, const std::string& body, const BenchOptions& options) {
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+    std::vector<BenchResult> per_thread(options.concurrency);
+    {
+        std::vector<std::jthread> threads;
+        for (auto& result : per_thread) {
+            threads.emplace_back([&client, &url, &body, &result, deadline] {
+                while (Clock::now() < deadline) {
+                    const auto request_start = Clock::now();
+                    try {
+                        const HttpResponse response = body.empty() ? client.get(url) : client.post(url, body);
+                        result.latenciesMicros.push_back(elapsed_micros(request_start));
+                        result.bytesReceived += response.body.size();
+                    } catch (const CurlException& e) {
+                        if (result.errors++ == 0) result.firstError = e.what();
+                    }
+                }
+            });
+        }
+    }
+    BenchResult total;
+    total.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& result : per_thread) {
+        total.latenciesMicros.insert(total.latenciesMicros.end(), result.latenciesMicros.begin(), result.latenciesMicros.end());
+        if (total.firstError.empty()) total.firstError = result.firstError;
+        total.errors += result.errors;
+        total.bytesReceived += result.bytesReceived;
+    }
+    return total;
+}
+
+// Keeps `concurrency` asynchronous requests in flight on the client's event loop until the deadline.
+// Completion handlers hold a reference to the run, so it outlives the last of them.
+class AsyncRun : public std::enable_shared_from_this<AsyncRun> {
+public:
+    AsyncRun(const HttpClient& client, const std::string& url, const std::string& body, const BenchOptions& options)
+        : m_client(client), m_url(url), m_body(body), m_active(options.concurrency),
+          m_deadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds))) {}
+
+    [[nodiscard]] BenchResult run(std::size_t concurrency) {
+        const auto start = Clock::now();
+        auto finished = m_done.get_future();
+        for (std::size_t i = 0; i < concurrency; ++i) start_request();
+        finished.wait();
+        std::scoped_lock lock(m_mutex);
+        m_result.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return std::move(m_result);
+    }
+
+private:
+    void start_request() {
+        const auto request_start = Clock::now();
+        auto on_complete = [this, self = shared_from_this(), request_start](std::expected<HttpResponse, CurlError> result) {
+            {
+                std::scoped_lock lock(m_mutex);
+                if (result) {
+                    m_result.latenciesMicros.push_back(elapsed_micros(request_start));
+                    m_result.bytesReceived += result->body.size();
+                } else if (m_result.errors++ == 0) {
+                    m_result.firstError = result.error().message;
+                }
+            }
+            if (Clock::now() < m_deadline) {
+                start_request();
+            } else if (m_active.fetch_sub(1) == 1) {
+                m_done.set_value();
+            }
+        };
+        if (m_body.empty()) {
+            m_client.getAsync(m_url, std::move(on_complete));
+        } else {
+            m_client.postAsync(m_url, m_body, std::move(on_complete));
+        }
+    }
+
+    const HttpClient& m_client;
+    const std::string& m_url;
+    const std::string& m_body;
+    std::atomic<std::size_t> m_active;
+    Clock::time_point m_deadline;
+    std::mutex m_mutex;
+    BenchResult m_result;
+    std::promise<void> m_done;
+};
+
+void print_report(const BenchOptions& options, BenchResult& result) {
+    auto& latencies = result.latenciesMicros;
+    std::ranges::sort(latencies);
+    const auto percentile = [&latencies](double quantile) -> std::uint32_t {
+        if (latencies.empty()) return 0;
+        const auto index = static_cast<std::size_t>(quantile * static_cast<double>(latencies.size() - 1));
+        return latencies[index];
+    };
+    const double requests_per_second = static_cast<double>(latencies.size()) / result.elapsedSeconds;
+    const double megabytes_per_second = static_cast<double>(result.bytesReceived) / result.elapsedSeconds / (1024.0 * 1024.0);
+
+    std::printf("mode=%s http=%s concurrency=%zu request-size=%zu response-size=%zu duration=%.1fs\n",
+                options.mode.c_str(), options.http.c_str(), options.concurrency, options.requestSize, options.responseSize, result.elapsedSeconds);
+    std::printf("requests: %zu ok, %zu errors\n", latencies.size(), result.errors);
+    if (!result.firstError.empty()) {
+        std::printf("first error: %s\n", result.firstError.c_str());
+    }
+    std::printf("throughput: %.0f req/s, %.1f MiB/s received\n", requests_per_second, megabytes_per_second);
+    std::printf("latency (us): p50=%u p90=%u p99=%u p999=%u max=%u\n",
+                percentile(0.50), percentile(0.90), percentile(0.99), percentile(0.999), latencies.empty() ? 0U : latencies.back());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchOptions options = parse_options(argc, argv);
+        LoopbackServer server(options.responseSize);
+
+        HttpClientConfig config;
+        config.httpVersion = options.http == "2" ? HttpVersion::Http2PriorKnowledge : HttpVersion::Http1_1;
+        config.handlePoolSize = options.concurrency;
+        HttpClient client(config);
+
+        const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + "/bench";
+        const std::string body(options.requestSize, 'b');
+        BenchResult result = options.mode == "sync" ? run_sync(client, url, body, options)
+                                                    : std::make_shared<AsyncRun>(client, url, body, options)->run(options.concurrency);
+        print_report(options, result);
+        return result.errors == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 2;
+    }
+}
@@ -12,6 +12,49 @@
 #include <limits>
 #include <functional> // For std::less
 #include <cstdlib>    // for std::abort
+#include <mutex>
+#include <shared_mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+#include <cerrno>
+#include <exception>
+#include <string_view>
+#include <stdexcept>
+#include <cstring>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <system_error>
+#include <random>
+#include <condition_variable>
+#include <list>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#include <share.h>
+#else
+#include <unistd.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef HTTPCLIENT_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
 
 namespace {
 
@@ -35,192 +78,3919 @@ public:
 
 const CurlGlobalInitializer global_curl_initializer;
 
-} // namespace
+// Thread-safe, bounded pool of CURL easy handles.
+// Idle handles keep their connection cache, DNS cache and TLS session cache,
+// so a request served from the pool can skip the TCP and TLS handshakes.
+class CurlHandlePool {
+public:
+    explicit CurlHandlePool(std::size_t capacity) : m_capacity(capacity) {
+        m_idle.reserve(capacity);
+    }
+    ~CurlHandlePool() {
+        for (CURL* curl : m_idle) {
+            curl_easy_cleanup(curl);
+        }
+    }
+    CurlHandlePool(const CurlHandlePool&) = delete;
+    CurlHandlePool& operator=(const CurlHandlePool&) = delete;
+    CurlHandlePool(CurlHandlePool&&) = delete;
+    CurlHandlePool& operator=(CurlHandlePool&&) = delete;
 
+    // Checks out an idle handle, or creates a new one if the pool is empty.
+    [[nodiscard]] CURL* acquire() {
+        {
+            std::scoped_lock lock(m_mutex);
+            if (!m_idle.empty()) {
+                CURL* curl = m_idle.back();
+                m_idle.pop_back();
+                return curl;
+            }
+        }
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            throw CurlException("Failed to create CURL easy handle.");
+        }
+        return curl;
+    }
 
-// Private implementation of the HttpClient.
-class HttpClient::Impl {
+    // Resets the handle's options and returns it to the pool, or frees it if the pool is full.
+    void release(/* NOSONAR */ CURL* curl) noexcept {
+        curl_easy_reset(curl);
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_idle.size() < m_capacity) {
+                m_idle.push_back(curl);
+                return;
+            }
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    // Like release, but the handle is checked out before every idle one, and the least recently
+    // used handle is freed to make room if the pool is full. Used for handles with warmed caches.
+    void promote(/* NOSONAR */ CURL* curl) noexcept {
+        curl_easy_reset(curl);
+        CURL* evicted = curl;
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_capacity > 0) {
+                evicted = m_idle.size() < m_capacity ? nullptr : m_idle.front();
+                if (evicted) m_idle.erase(m_idle.begin());
+                m_idle.push_back(curl);
+            }
+        }
+        if (evicted) curl_easy_cleanup(evicted);
+    }
+
+private:
+    const std::size_t m_capacity;
+    std::mutex m_mutex;
+    std::vector<CURL*> m_idle;
+};
+
+// Owns a CURLSH object that lets every handle of a client share DNS, TLS session
+// and connection caches. Each shared data type gets its own reader/writer lock, so
+// e.g. DNS lookups never wait on a thread that is storing a TLS session.
+class CurlShare {
 public:
-    explicit Impl(HttpClientConfig config) : m_config(std::move(config)) {}
+    explicit CurlShare(const HttpClientConfig& config)
+        : m_maxConnects(config.shareConnections ? config.sharedConnectionCacheSize : 0L) {
+        if (!config.shareDnsCache && !config.shareTlsSessions && !config.shareConnections) {
+            return;
+        }
+        m_share = curl_share_init();
+        if (!m_share) {
+            throw CurlException("Failed to create CURL share handle.");
+        }
+        curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockCallback);
+        curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+        curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+        if (config.shareDnsCache) curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        if (config.shareTlsSessions) curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        if (config.shareConnections) curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+    ~CurlShare() {
+        if (m_share) curl_share_cleanup(m_share);
+    }
+    CurlShare(const CurlShare&) = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+    CurlShare(CurlShare&&) = delete;
+    CurlShare& operator=(CurlShare&&) = delete;
+
+    // Attaches the share object to an easy handle. Does nothing if sharing is disabled.
+    void attach(/* NOSONAR */ CURL* curl) const {
+        if (!m_share) return;
+        curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+        // libcurl sizes a shared connection cache from the handle's limit, whose default
+        // of 5 would evict connections as soon as a handful of threads run concurrently.
+        if (m_maxConnects > 0) curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, m_maxConnects);
+    }
 
-    [[nodiscard]] HttpResponse performRequest(const std::string& url,
-                                              const std::optional<std::string>& postBody,
-                                              const std::optional<std::vector<HttpFormPart>>& formParts,
-                                              const std::map<std::string, std::string, std::less<>>& headers) const;
 private:
-    HttpClientConfig m_config;
+    struct DataLock {
+        std::shared_mutex mutex;
+        // Set while the lock is held exclusively, so the unlock callback (which is not
+        // told the access mode) knows which kind of unlock to perform.
+        std::atomic<bool> exclusive{false};
+    };
 
-    // Helper functions to refactor performRequest
-    void configure_common_options(/* NOSONAR */ CURL* curl, const std::string& url, HttpResponse& response) const;
-    [[nodiscard]] curl_slist* build_headers(const std::map<std::string, std::string, std::less<>>& headers) const;
-    void configure_post_body(/* NOSONAR */ CURL* curl, const std::string& postBody) const;
-    [[nodiscard]] curl_mime* build_multipart_form(/* NOSONAR */ CURL* curl, const std::vector<HttpFormPart>& formParts) const;
-    
-    // Callbacks for libcurl
-    static size_t writeCallback(const char* ptr, size_t size, size_t nmemb, /* NOSONAR */ void* userdata);
-    static size_t headerCallback(const char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata);
+    static void lockCallback(/* NOSONAR */ CURL*, curl_lock_data data, curl_lock_access access, /* NOSONAR */ void* userptr) {
+        auto& lock = static_cast<CurlShare*>(userptr)->m_locks[static_cast<std::size_t>(data)];
+        if (access == CURL_LOCK_ACCESS_SHARED) {
+            lock.mutex.lock_shared();
+        } else {
+            lock.mutex.lock();
+            lock.exclusive.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    static void unlockCallback(/* NOSONAR */ CURL*, curl_lock_data data, /* NOSONAR */ void* userptr) {
+        auto& lock = static_cast<CurlShare*>(userptr)->m_locks[static_cast<std::size_t>(data)];
+        if (lock.exclusive.load(std::memory_order_relaxed)) {
+            lock.exclusive.store(false, std::memory_order_relaxed);
+            lock.mutex.unlock();
+        } else {
+            lock.mutex.unlock_shared();
+        }
+    }
+
+    CURLSH* m_share = nullptr;
+    const long m_maxConnects;
+    std::array<DataLock, CURL_LOCK_DATA_LAST> m_locks;
 };
 
-// --- Callback Implementations ---
+// Returns a checked-out handle to its pool when the owning unique_ptr goes out of scope.
+struct PooledHandleReleaser {
+    CurlHandlePool* pool;
+    void operator()(/* NOSONAR */ CURL* curl) const noexcept { pool->release(curl); }
+};
 
-size_t HttpClient::Impl::writeCallback(const char* ptr, size_t size, size_t nmemb, /* NOSONAR */ void* userdata) {
-    if (userdata == nullptr) return 0;
-    auto* responseBody = static_cast<std::string*>(userdata);
-    const size_t total_size = size * nmemb;
-    try {
-        responseBody->append(ptr, total_size);
-    } catch (const std::bad_alloc&) {
-        return 0; 
+using PooledHandle = std::unique_ptr<CURL, PooledHandleReleaser>;
+
+// One event loop that drives asynchronous transfers on a background thread.
+// On Linux the loop is built on curl_multi_socket_action wired to epoll, with an
+// eventfd used to wake it up when new commands arrive. Other platforms
+// fall back to curl_multi_poll/curl_multi_wakeup.
+//
+// Submissions, cancellations and resumes reach the loop through a lock-free
+// multi-producer queue. Submitted transfers wait in one FIFO per priority class
+// while maxInFlight transfers are running, and are started by stride scheduling:
+// each class advances a virtual clock by 1/weight per started transfer, and the
+// waiting class with the earliest clock goes next. A request still waiting when
+// the queue deadline of its class passes fails without being sent.
+class EventLoop {
+public:
+    // Invoked on the loop thread once the transfer has finished or been aborted.
+    using Completion = std::move_only_function<void(CURLcode)>;
+
+    EventLoop(bool multiplex, const HttpSchedulerPolicy& policy, std::size_t maxInFlight, std::optional<unsigned> cpu)
+        : m_maxInFlight(maxInFlight) {
+        for (std::size_t i = 0; i < PRIORITY_CLASSES; ++i) {
+            m_classes[i].stride = STRIDE_SCALE / std::max(policy.weights[i], 1U);
+            m_classes[i].deadline = policy.queueDeadlines[i];
+        }
+        m_multi = curl_multi_init();
+        if (!m_multi) {
+            throw CurlException("Failed to create CURL multi handle.");
+        }
+        curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+#ifdef __linux__
+        m_epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_epoll < 0 || m_wakeFd < 0) {
+            closeDescriptors();
+            curl_multi_cleanup(m_multi);
+            throw CurlException("Failed to create the event loop descriptors.");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = m_wakeFd;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+        curl_multi_setopt(m_multi, CURLMOPT_SOCKETFUNCTION, socketCallback);
+        curl_multi_setopt(m_multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(m_multi, CURLMOPT_TIMERFUNCTION, timerCallback);
+        curl_multi_setopt(m_multi, CURLMOPT_TIMERDATA, this);
+#endif
+        m_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+#ifdef __linux__
+        if (cpu) {
+            // Best effort: a restricted cpuset only leaves the thread unpinned.
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(*cpu, &cpus);
+            static_cast<void>(pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpus), &cpus));
+        }
+#else
+        static_cast<void>(cpu);
+#endif
     }
-    return total_size;
+
+    ~EventLoop() {
+        m_thread.request_stop();
+        wake();
+        m_thread.join();
+        curl_multi_cleanup(m_multi);
+#ifdef __linux__
+        closeDescriptors();
+#endif
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    EventLoop(EventLoop&&) = delete;
+    EventLoop& operator=(EventLoop&&) = delete;
+
+    // Queues a fully configured easy handle for execution. Safe to call from any thread.
+    void submit(/* NOSONAR */ CURL* curl, std::uint64_t ticket, HttpPriority priority, Completion done) {
+        push(std::make_unique<Command>(Command{.kind = Command::Kind::Submit, .curl = curl, .ticket = ticket,
+                                               .priority = priority, .done = std::move(done)}));
+    }
+
+    // Aborts a submitted transfer, which completes with CURLE_ABORTED_BY_CALLBACK. Does nothing if
+    // it has already finished. Safe to call from any thread.
+    void cancel(std::uint64_t ticket) {
+        push(std::make_unique<Command>(Command{.kind = Command::Kind::Cancel, .ticket = ticket}));
+    }
+
+    // Unpauses a transfer whose upload paused for lack of data. Handles that are not running here are
+    // skipped; an unneeded resume of a reused handle is harmless, as its read callback pauses again.
+    // Safe to call from any thread.
+    void resume(/* NOSONAR */ CURL* curl) {
+        push(std::make_unique<Command>(Command{.kind = Command::Kind::Resume, .curl = curl}));
+    }
+
+private:
+    static constexpr std::size_t PRIORITY_CLASSES = 3;
+    static constexpr std::uint64_t STRIDE_SCALE = 1U << 20;
+
+    struct Command {
+        enum class Kind { Submit, Cancel, Resume };
+        Kind kind = Kind::Submit;
+        CURL* curl = nullptr;
+        std::uint64_t ticket = 0;
+        HttpPriority priority = HttpPriority::Normal;
+        Completion done{};
+        Command* next = nullptr;
+    };
+
+    struct Waiting {
+        CURL* curl;
+        std::uint64_t ticket;
+        Completion done;
+        std::optional<std::chrono::steady_clock::time_point> expires;
+    };
+
+    struct PriorityClass {
+        std::deque<Waiting> waiting;
+        std::uint64_t stride = 1;
+        std::uint64_t pass = 0;
+        std::chrono::milliseconds deadline{0};
+    };
+
+    // Pushes onto an intrusive stack with a CAS, so producers never block each other or the loop.
+    // Only the push that finds the stack empty wakes the loop: any later one is picked up by the same drain.
+    void push(std::unique_ptr<Command> command) {
+        // Once the CAS succeeds the loop may already own the node, so only the local copy of the head is read after it.
+        Command* node = command.release();
+        Command* head = m_commands.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!m_commands.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        if (head == nullptr) {
+            wake();
+        }
+    }
+
+    // Takes every command pushed so far and returns them oldest first.
+    [[nodiscard]] Command* takeCommands() noexcept {
+        Command* newest = m_commands.exchange(nullptr, std::memory_order_acquire);
+        Command* oldest = nullptr;
+        while (newest) {
+            Command* next = newest->next;
+            newest->next = oldest;
+            oldest = newest;
+            newest = next;
+        }
+        return oldest;
+    }
+
+    void wake() noexcept {
+#ifdef __linux__
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto written = write(m_wakeFd, &one, sizeof(one));
+#else
+        curl_multi_wakeup(m_multi);
+#endif
+    }
+
+    void run(const std::stop_token& stop) {
+        while (!stop.stop_requested()) {
+            processCommands();
+            const auto now = std::chrono::steady_clock::now();
+            dropExpired(now);
+            dispatch();
+            waitAndDrive();
+            completeFinished();
+        }
+        abortAll();
+    }
+
+    void processCommands() {
+        for (Command* command = takeCommands(); command;) {
+            std::unique_ptr<Command> owned(command);
+            command = command->next;
+            switch (owned->kind) {
+                case Command::Kind::Submit: enqueue(*owned); break;
+                case Command::Kind::Cancel: cancelTicket(owned->ticket); break;
+                case Command::Kind::Resume:
+                    if (m_active.contains(owned->curl)) curl_easy_pause(owned->curl, CURLPAUSE_CONT);
+                    break;
+            }
+        }
+    }
+
+    void enqueue(Command& command) {
+        PriorityClass& cls = m_classes[static_cast<std::size_t>(command.priority)];
+        if (cls.waiting.empty()) {
+            // A class that was idle rejoins at the current virtual time instead of cashing in its idle period.
+            cls.pass = std::max(cls.pass, m_virtualTime);
+        }
+        std::optional<std::chrono::steady_clock::time_point> expires;
+        if (cls.deadline.count() > 0) expires = std::chrono::steady_clock::now() + cls.deadline;
+        cls.waiting.push_back({command.curl, command.ticket, std::move(command.done), expires});
+    }
+
+    // Starts waiting transfers while there is room, picking the class with the earliest virtual time.
+    void dispatch() {
+        while (m_maxInFlight == 0 || m_active.size() < m_maxInFlight) {
+            PriorityClass* next = nullptr;
+            for (PriorityClass& cls : m_classes) {
+                if (!cls.waiting.empty() && (!next || cls.pass < next->pass)) next = &cls;
+            }
+            if (!next) return;
+            Waiting waiting = std::move(next->waiting.front());
+            next->waiting.pop_front();
+            m_virtualTime = next->pass;
+            next->pass += next->stride;
+            if (curl_multi_add_handle(m_multi, waiting.curl) != CURLM_OK) {
+                waiting.done(CURLE_FAILED_INIT);
+                continue;
+            }
+            m_active.try_emplace(waiting.curl, waiting.ticket, std::move(waiting.done));
+        }
+    }
+
+    // Every class has a single deadline, so its expired transfers are always at the front of its queue.
+    void dropExpired(std::chrono::steady_clock::time_point now) {
+        for (PriorityClass& cls : m_classes) {
+            while (!cls.waiting.empty() && cls.waiting.front().expires && *cls.waiting.front().expires <= now) {
+                Completion done = std::move(cls.waiting.front().done);
+                cls.waiting.pop_front();
+                done(CURLE_OPERATION_TIMEDOUT);
+            }
+        }
+    }
+
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> nextExpiry() const noexcept {
+        std::optional<std::chrono::steady_clock::time_point> next;
+        for (const PriorityClass& cls : m_classes) {
+            if (cls.waiting.empty() || !cls.waiting.front().expires) continue;
+            if (!next || *cls.waiting.front().expires < *next) next = cls.waiting.front().expires;
+        }
+        return next;
+    }
+
+    void cancelTicket(std::uint64_t ticket) {
+        for (PriorityClass& cls : m_classes) {
+            const auto waiting = std::ranges::find_if(cls.waiting, [ticket](const Waiting& entry) { return entry.ticket == ticket; });
+            if (waiting != cls.waiting.end()) {
+                Completion done = std::move(waiting->done);
+                cls.waiting.erase(waiting);
+                done(CURLE_ABORTED_BY_CALLBACK);
+                return;
+            }
+        }
+        const auto it = std::ranges::find_if(m_active, [ticket](const auto& entry) { return entry.second.first == ticket; });
+        if (it == m_active.end()) return;
+        curl_multi_remove_handle(m_multi, it->first);
+        auto node = m_active.extract(it);
+        node.mapped().second(CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    void completeFinished() {
+        int remaining = 0;
+        while (CURLMsg* message = curl_multi_info_read(m_multi, &remaining)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            CURL* curl = message->easy_handle;
+            const CURLcode result = message->data.result;
+            curl_multi_remove_handle(m_multi, curl);
+            if (auto node = m_active.extract(curl)) {
+                node.mapped().second(result);
+            }
+        }
+    }
+
+    // Fails every transfer that is still queued or running when the loop shuts down.
+    void abortAll() {
+        for (Command* command = takeCommands(); command;) {
+            std::unique_ptr<Command> owned(command);
+            command = command->next;
+            if (owned->kind == Command::Kind::Submit) owned->done(CURLE_ABORTED_BY_CALLBACK);
+        }
+        for (PriorityClass& cls : m_classes) {
+            for (Waiting& waiting : cls.waiting) {
+                waiting.done(CURLE_ABORTED_BY_CALLBACK);
+            }
+            cls.waiting.clear();
+        }
+        for (auto& [curl, active] : m_active) {
+            curl_multi_remove_handle(m_multi, curl);
+            active.second(CURLE_ABORTED_BY_CALLBACK);
+        }
+        m_active.clear();
+    }
+
+#ifdef __linux__
+    void waitAndDrive() {
+        static constexpr int MAX_EVENTS = 64;
+        std::array<epoll_event, MAX_EVENTS> events{};
+        const int ready = epoll_wait(m_epoll, events.data(), MAX_EVENTS, nextTimeoutMs());
+        int running = 0;
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_wakeFd) {
+                std::uint64_t count = 0;
+                [[maybe_unused]] const auto drained = read(m_wakeFd, &count, sizeof(count));
+                continue;
+            }
+            int mask = 0;
+            if (events[i].events & EPOLLIN) mask |= CURL_CSELECT_IN;
+            if (events[i].events & EPOLLOUT) mask |= CURL_CSELECT_OUT;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) mask |= CURL_CSELECT_ERR;
+            curl_multi_socket_action(m_multi, fd, mask, &running);
+        }
+        if (m_deadline && std::chrono::steady_clock::now() >= *m_deadline) {
+            m_deadline.reset();
+            curl_multi_socket_action(m_multi, CURL_SOCKET_TIMEOUT, 0, &running);
+        }
+    }
+
+    [[nodiscard]] int nextTimeoutMs() const {
+        std::optional<std::chrono::steady_clock::time_point> wakeup = nextExpiry();
+        if (m_deadline && (!wakeup || *m_deadline < *wakeup)) wakeup = m_deadline;
+        if (!wakeup) return -1;
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*wakeup - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 0));
+    }
+
+    static int socketCallback(/* NOSONAR */ CURL*, curl_socket_t socket, int what, /* NOSONAR */ void* userp, /* NOSONAR */ void* socketp) {
+        auto* self = static_cast<EventLoop*>(userp);
+        if (what == CURL_POLL_REMOVE) {
+            epoll_ctl(self->m_epoll, EPOLL_CTL_DEL, socket, nullptr);
+            return 0;
+        }
+        epoll_event event{};
+        event.data.fd = socket;
+        if (what & CURL_POLL_IN) event.events |= EPOLLIN;
+        if (what & CURL_POLL_OUT) event.events |= EPOLLOUT;
+        if (socketp) {
+            epoll_ctl(self->m_epoll, EPOLL_CTL_MOD, socket, &event);
+        } else {
+            // A descriptor number can be recycled by the kernel before libcurl reports the old one removed.
+            if (epoll_ctl(self->m_epoll, EPOLL_CTL_ADD, socket, &event) != 0 && errno == EEXIST) {
+                epoll_ctl(self->m_epoll, EPOLL_CTL_MOD, socket, &event);
+            }
+            curl_multi_assign(self->m_multi, socket, self);
+        }
+        return 0;
+    }
+
+    static int timerCallback(/* NOSONAR */ CURLM*, long timeoutMs, /* NOSONAR */ void* userp) {
+        auto* self = static_cast<EventLoop*>(userp);
+        if (timeoutMs < 0) {
+            self->m_deadline.reset();
+        } else {
+            self->m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        }
+        return 0;
+    }
+
+    void closeDescriptors() noexcept {
+        if (m_wakeFd >= 0) close(m_wakeFd);
+        if (m_epoll >= 0) close(m_epoll);
+    }
+
+    int m_epoll = -1;
+    int m_wakeFd = -1;
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;
+#else
+    void waitAndDrive() {
+        static constexpr std::chrono::milliseconds POLL_TIMEOUT{1000};
+        auto timeout = POLL_TIMEOUT;
+        if (const auto expiry = nextExpiry()) {
+            timeout = std::clamp(std::chrono::ceil<std::chrono::milliseconds>(*expiry - std::chrono::steady_clock::now()),
+                                 std::chrono::milliseconds{0}, POLL_TIMEOUT);
+        }
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+        curl_multi_poll(m_multi, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+        curl_multi_perform(m_multi, &running);
+    }
+#endif
+
+    CURLM* m_multi = nullptr;
+    // 0 means unlimited.
+    const std::size_t m_maxInFlight;
+    std::atomic<Command*> m_commands{nullptr};
+    // Only touched by the loop thread.
+    std::array<PriorityClass, PRIORITY_CLASSES> m_classes;
+    std::uint64_t m_virtualTime = 0;
+    // Only touched by the loop thread, keyed by handle and holding the ticket and completion.
+    std::unordered_map<CURL*, std::pair<std::uint64_t, Completion>> m_active;
+    std::jthread m_thread;
+};
+
+// Spreads asynchronous transfers over HttpSchedulerPolicy::loopThreads event loops. Tickets are
+// handed out round-robin, so a ticket also names the loop its transfer runs on.
+class MultiEngine {
+public:
+    using Completion = EventLoop::Completion;
+
+    MultiEngine(bool multiplex, const HttpSchedulerPolicy& policy) {
+        const std::size_t loops = std::max<std::size_t>(policy.loopThreads, 1);
+        // The in-flight limit is split between the loops, rounding up so it never drops to unlimited.
+        const std::size_t per_loop = policy.maxInFlight == 0 ? 0 : (policy.maxInFlight + loops - 1) / loops;
+        const unsigned cores = std::max(std::thread::hardware_concurrency(), 1U);
+        m_loops.reserve(loops);
+        for (std::size_t i = 0; i < loops; ++i) {
+            const auto cpu = policy.pinLoopThreads ? std::optional<unsigned>(static_cast<unsigned>(i % cores)) : std::nullopt;
+            m_loops.push_back(std::make_unique<EventLoop>(multiplex, policy, per_loop, cpu));
+        }
+    }
+
+    // Queues a fully configured easy handle for execution. Safe to call from any thread.
+    // Returns a ticket for cancel(); tickets are never reused, unlike the handles themselves.
+    std::uint64_t submit(/* NOSONAR */ CURL* curl, HttpPriority priority, Completion done) {
+        const std::uint64_t ticket = m_lastTicket.fetch_add(1, std::memory_order_relaxed) + 1;
+        loopFor(ticket).submit(curl, ticket, priority, std::move(done));
+        return ticket;
+    }
+
+    // Aborts a submitted transfer, which completes with CURLE_ABORTED_BY_CALLBACK. Does nothing if
+    // it has already finished. Safe to call from any thread.
+    void cancel(std::uint64_t ticket) {
+        loopFor(ticket).cancel(ticket);
+    }
+
+    // The handle does not say which loop runs it, so every loop checks its own transfers. Pauses only
+    // happen while an upload stream waits for its producer, so this stays rare.
+    void resume(/* NOSONAR */ CURL* curl) {
+        for (const auto& loop : m_loops) {
+            loop->resume(curl);
+        }
+    }
+
+private:
+    [[nodiscard]] EventLoop& loopFor(std::uint64_t ticket) const noexcept {
+        return *m_loops[static_cast<std::size_t>(ticket % m_loops.size())];
+    }
+
+    std::vector<std::unique_ptr<EventLoop>> m_loops;
+    std::atomic<std::uint64_t> m_lastTicket{0};
+};
+
+} // namespace
+
+
+// --- HttpHeaders methods ---
+
+namespace {
+
+constexpr std::string_view HEADER_WHITESPACE = " \t";
+constexpr std::string_view HEADER_TRAILING_WHITESPACE = " \t\r\n";
+
+[[nodiscard]] constexpr char ascii_lower(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
 }
 
-size_t HttpClient::Impl::headerCallback(const char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata) {
-    if (userdata == nullptr) return 0;
-    auto* responseHeaders = static_cast<std::map<std::string, std::string, std::less<>>*>(userdata);
-    std::string header(buffer, size * nitems);
-    if (const size_t colon_pos = header.find(':'); colon_pos != std::string::npos) {
-        std::string key = header.substr(0, colon_pos);
-        std::string value = header.substr(colon_pos + 1);
-        key.erase(0, key.find_first_not_of(" \t"));
-        key.erase(key.find_last_not_of(" \t") + 1);
-        value.erase(0, value.find_first_not_of(" \t"));
-        value.erase(value.find_last_not_of(" \t\r\n") + 1);
-        (*responseHeaders)[key] = value;
+[[nodiscard]] bool header_name_less(std::string_view lhs, std::string_view rhs) noexcept {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                                        [](char a, char b) { return ascii_lower(a) < ascii_lower(b); });
+}
+
+[[nodiscard]] bool header_name_equal(std::string_view lhs, std::string_view rhs) noexcept {
+    return std::ranges::equal(lhs, rhs, [](char a, char b) { return ascii_lower(a) == ascii_lower(b); });
+}
+
+[[nodiscard]] std::string_view trim(std::string_view text, std::string_view leading, std::string_view trailing) noexcept {
+    const size_t first = text.find_first_not_of(leading);
+    if (first == std::string_view::npos) return {};
+    text.remove_prefix(first);
+    return text.substr(0, text.find_last_not_of(trailing) + 1);
+}
+
+} // namespace
+
+void HttpHeaders::append(std::string_view line) {
+    if (const size_t colon_pos = line.find(':'); colon_pos != std::string_view::npos) {
+        add(trim(line.substr(0, colon_pos), HEADER_WHITESPACE, HEADER_WHITESPACE),
+            trim(line.substr(colon_pos + 1), HEADER_WHITESPACE, HEADER_TRAILING_WHITESPACE));
     }
-    return size * nitems;
 }
 
-// --- Refactored Helper Functions ---
+HttpHeaders::~HttpHeaders() {
+    dropMap();
+}
 
-void HttpClient::Impl::configure_common_options(/* NOSONAR */ CURL* curl, const std::string& url, HttpResponse& response) const {
-    static constexpr const char* USER_AGENT = "cpp-http-client/1.0";
-    static constexpr long FOLLOW_REDIRECTS = 1L;
+HttpHeaders::HttpHeaders(const HttpHeaders& other) : m_arena(other.m_arena), m_entries(other.m_entries) {}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, m_config.connectTimeoutMs);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, m_config.requestTimeoutMs);
-    curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2); //NOSONAR
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, FOLLOW_REDIRECTS);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, USER_AGENT);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
-    
-    if (m_config.clientCertPath) curl_easy_setopt(curl, CURLOPT_SSLCERT, m_config.clientCertPath->c_str());
-    if (m_config.clientKeyPath) curl_easy_setopt(curl, CURLOPT_SSLKEY, m_config.clientKeyPath->c_str());
-    if (m_config.clientKeyPassword) curl_easy_setopt(curl, CURLOPT_KEYPASSWD, m_config.clientKeyPassword->c_str());
+HttpHeaders& HttpHeaders::operator=(const HttpHeaders& other) {
+    if (this != &other) {
+        m_arena = other.m_arena;
+        m_entries = other.m_entries;
+        dropMap();
+    }
+    return *this;
 }
 
-[[nodiscard]] curl_slist* HttpClient::Impl::build_headers(const std::map<std::string, std::string, std::less<>>& headers) const {
-    curl_slist* header_list = nullptr;
-    for (const auto& [key, value] : headers) {
-        std::string header_string = key + ": " + value;
-        header_list = curl_slist_append(header_list, header_string.c_str());
+HttpHeaders::HttpHeaders(HttpHeaders&& other) noexcept
+    : m_arena(std::move(other.m_arena)),
+      m_entries(std::move(other.m_entries)),
+      m_map(other.m_map.exchange(nullptr, std::memory_order_acq_rel)) {}
+
+HttpHeaders& HttpHeaders::operator=(HttpHeaders&& other) noexcept {
+    if (this != &other) {
+        m_arena = std::move(other.m_arena);
+        m_entries = std::move(other.m_entries);
+        delete m_map.exchange(other.m_map.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_acq_rel);
     }
-    return header_list;
+    return *this;
 }
 
-void HttpClient::Impl::configure_post_body(/* NOSONAR */ CURL* curl, const std::string& postBody) const {
-    const size_t body_length = postBody.length();
-    if (body_length > static_cast<size_t>(std::numeric_limits<long>::max())) {
-        throw CurlException("POST body is too large to be handled by libcurl.");
+void HttpHeaders::dropMap() noexcept {
+    delete m_map.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void HttpHeaders::add(std::string_view name, std::string_view value) {
+    dropMap();
+    // Typical responses fit in these, so a response usually costs exactly two allocations for its headers.
+    static constexpr size_t INITIAL_ARENA_BYTES = 1024;
+    static constexpr size_t INITIAL_ENTRIES = 16;
+    if (m_entries.capacity() == 0) {
+        m_arena.reserve(INITIAL_ARENA_BYTES);
+        m_entries.reserve(INITIAL_ENTRIES);
     }
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postBody.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body_length));
+
+    const Entry entry{static_cast<std::uint32_t>(m_arena.size()), static_cast<std::uint32_t>(name.size()),
+                      static_cast<std::uint32_t>(m_arena.size() + name.size()), static_cast<std::uint32_t>(value.size())};
+    const auto position = upperBound(name);
+    m_arena.append(name);
+    m_arena.append(value);
+    // Inserting after any equal names keeps repeated headers in arrival order.
+    m_entries.insert(position, entry);
 }
 
-[[nodiscard]] curl_mime* HttpClient::Impl::build_multipart_form(/* NOSONAR */ CURL* curl, const std::vector<HttpFormPart>& formParts) const {
-    curl_mime* mime = curl_mime_init(curl);
-    if (!mime) {
-        throw CurlException("curl_mime_init() failed.");
+void HttpHeaders::clear() noexcept {
+    m_arena.clear();
+    m_entries.clear();
+    dropMap();
+}
+
+std::optional<std::string_view> HttpHeaders::get(std::string_view name) const {
+    const size_t index = lastIndexOf(name);
+    if (index == std::string_view::npos) return std::nullopt;
+    return entryAt(index).second;
+}
+
+std::string_view HttpHeaders::at(std::string_view name) const {
+    const size_t index = lastIndexOf(name);
+    if (index == std::string_view::npos) {
+        throw std::out_of_range("HttpHeaders::at: header not found: " + std::string(name));
     }
+    return entryAt(index).second;
+}
 
-    for (const auto& part : formParts) {
-        curl_mimepart* mime_part = curl_mime_addpart(mime);
-        curl_mime_name(mime_part, part.name.c_str());
+HttpHeaders::const_iterator HttpHeaders::find(std::string_view name) const {
+    const size_t index = lastIndexOf(name);
+    return index == std::string_view::npos ? end() : const_iterator(this, index);
+}
 
-        if (std::holds_alternative<std::string>(part.contents)) {
-            const auto& value = std::get<std::string>(part.contents);
-            curl_mime_data(mime_part, value.c_str(), value.length());
-        } else {
-            const auto& file = std::get<HttpFormFile>(part.contents);
-            curl_mime_filedata(mime_part, file.filePath.c_str());
-            if (file.contentType) {
-                curl_mime_type(mime_part, file.contentType->c_str());
-            }
-        }
+size_t HttpHeaders::count(std::string_view name) const {
+    const auto last = upperBound(name);
+    const auto first = std::lower_bound(m_entries.cbegin(), last, name,
+                                        [this](const Entry& e, std::string_view key) { return header_name_less(nameOf(e), key); });
+    return static_cast<size_t>(last - first);
+}
+
+const HttpHeaders::Map& HttpHeaders::asMap() const {
+    if (const Map* built = m_map.load(std::memory_order_acquire)) {
+        return *built;
     }
-    return mime;
+    auto map = std::make_unique<Map>();
+    for (const auto& [name, value] : *this) {
+        map->insert_or_assign(std::string(name), std::string(value));
+    }
+    // Concurrent first calls may both build a map; the first one published wins and the others are discarded.
+    const Map* published = nullptr;
+    if (m_map.compare_exchange_strong(published, map.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return *map.release();
+    }
+    return *published;
+}
+
+HttpHeaders::value_type HttpHeaders::entryAt(size_t index) const {
+    const Entry& entry = m_entries[index];
+    return {nameOf(entry), std::string_view(m_arena).substr(entry.valueOffset, entry.valueLength)};
 }
 
+std::string_view HttpHeaders::nameOf(const Entry& entry) const {
+    return std::string_view(m_arena).substr(entry.nameOffset, entry.nameLength);
+}
 
-// --- Main Request Function ---
+std::vector<HttpHeaders::Entry>::const_iterator HttpHeaders::upperBound(std::string_view name) const {
+    return std::upper_bound(m_entries.cbegin(), m_entries.cend(), name,
+                            [this](std::string_view key, const Entry& e) { return header_name_less(key, nameOf(e)); });
+}
 
-[[nodiscard]] HttpResponse HttpClient::Impl::performRequest(const std::string& url,
-                                                            const std::optional<std::string>& postBody,
-                                                            const std::optional<std::vector<HttpFormPart>>& formParts,
-                                                            const std::map<std::string, std::string, std::less<>>& headers) const {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw CurlException("Failed to create CURL easy handle.");
+size_t HttpHeaders::lastIndexOf(std::string_view name) const {
+    const auto position = upperBound(name);
+    if (position == m_entries.begin() || !header_name_equal(nameOf(*std::prev(position)), name)) {
+        return std::string_view::npos;
     }
+    return static_cast<size_t>(std::prev(position) - m_entries.begin());
+}
 
-    // RAII for all libcurl resources
-    auto curl_deleter = [](CURL* c) { curl_easy_cleanup(c); };
-    std::unique_ptr<CURL, decltype(curl_deleter)> curl_ptr(curl, curl_deleter); //NOSONAR
 
-    auto slist_deleter = [](curl_slist* sl) { curl_slist_free_all(sl); };
-    std::unique_ptr<curl_slist, decltype(slist_deleter)> header_slist_ptr(build_headers(headers), slist_deleter); //NOSONAR
-    
-    auto mime_deleter = [](curl_mime* m) { if(m) curl_mime_free(m); };
-    std::unique_ptr<curl_mime, decltype(mime_deleter)> mime_ptr(nullptr, mime_deleter); //NOSONAR
-    
-    HttpResponse response;
-    
-    // Step 1: Configure all common options
-    configure_common_options(curl, url, response);
+// --- PreparedHeaders methods ---
 
-    // Step 2: Set headers
-    if (header_slist_ptr) {
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_slist_ptr.get());
+namespace {
+
+// Appends "key: value" to a header list. On failure the whole list is freed and CurlException is thrown.
+[[nodiscard]] curl_slist* append_header(curl_slist* list, const std::string& key, const std::string& value) {
+    std::string header_string;
+    header_string.reserve(key.size() + 2 + value.size());
+    header_string.append(key).append(": ").append(value);
+    curl_slist* appended = curl_slist_append(list, header_string.c_str());
+    if (!appended) {
+        curl_slist_free_all(list);
+        throw CurlException("curl_slist_append() failed.");
     }
+    return appended;
+}
 
-    // Step 3: Configure POST data (if any)
-    if (formParts) {
-        mime_ptr.reset(build_multipart_form(curl, *formParts));
-        curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime_ptr.get());
-    } else if (postBody) {
-        configure_post_body(curl, *postBody);
+// Copies a header list, so a transfer can extend it without touching a shared prepared list.
+[[nodiscard]] curl_slist* copy_headers(const curl_slist* list) {
+    curl_slist* copy = nullptr;
+    for (; list; list = list->next) {
+        curl_slist* appended = curl_slist_append(copy, list->data);
+        if (!appended) {
+            curl_slist_free_all(copy);
+            throw CurlException("curl_slist_append() failed.");
+        }
+        copy = appended;
     }
+    return copy;
+}
 
-    // Step 4: Perform the request
-    if (CURLcode res = curl_easy_perform(curl); res != CURLE_OK) {
-        throw CurlException(std::string("curl_easy_perform() failed: ") + curl_easy_strerror(res));
+// Returns the value of the last "name: value" entry of a header list.
+[[nodiscard]] std::optional<std::string_view> find_header(const curl_slist* list, std::string_view name) {
+    std::optional<std::string_view> value;
+    for (; list; list = list->next) {
+        const std::string_view line(list->data);
+        if (line.size() > name.size() && line[name.size()] == ':' && header_name_equal(line.substr(0, name.size()), name)) {
+            value = trim(line.substr(name.size() + 1), HEADER_WHITESPACE, HEADER_TRAILING_WHITESPACE);
+        }
     }
+    return value;
+}
 
-    // Step 5: Retrieve the status code
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.statusCode);
-    
-    return response;
+[[nodiscard]] bool has_header(const curl_slist* list, std::string_view name) {
+    for (; list; list = list->next) {
+        const std::string_view line(list->data);
+        if (line.size() > name.size() && (line[name.size()] == ':' || line[name.size()] == ';') &&
+            header_name_equal(line.substr(0, name.size()), name)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-// --- Public HttpClient methods ---
+#ifdef HTTPCLIENT_WITH_ZLIB
+// Compresses data into a gzip member in one pass. Returns nothing if the result would not be smaller.
+[[nodiscard]] std::optional<std::string> gzip_compress(std::string_view data) {
+    static constexpr int GZIP_WINDOW_BITS = 15 + 16;
+    static constexpr int MEMORY_LEVEL = 8;
 
-HttpClient::HttpClient(HttpClientConfig config) : pimpl(std::make_unique<Impl>(std::move(config))) {}
-HttpClient::~HttpClient() = default;
-HttpClient::HttpClient(HttpClient&&) noexcept = default;
-HttpClient& HttpClient::operator=(HttpClient&&) noexcept = default;
+    if (data.size() > std::numeric_limits<uInt>::max()) {
+        return std::nullopt;
+    }
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw CurlException("deflateInit2() failed.");
+    }
+    std::string compressed(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data())); // NOSONAR: zlib does not modify the input
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(compressed.data()); // NOSONAR: zlib's byte type
+    stream.avail_out = static_cast<uInt>(std::min<std::size_t>(compressed.size(), std::numeric_limits<uInt>::max()));
+    const int result = deflate(&stream, Z_FINISH);
+    const auto produced = static_cast<std::size_t>(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END || produced >= data.size()) {
+        return std::nullopt;
+    }
+    compressed.resize(produced);
+    return compressed;
+}
+#endif
 
-[[nodiscard]] HttpResponse HttpClient::get(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers) const {
-    return pimpl->performRequest(url, std::nullopt, std::nullopt, headers);
+} // namespace
+
+PreparedHeaders PreparedHeaders::fromMap(const std::map<std::string, std::string, std::less<>>& headers) {
+    curl_slist* list = nullptr;
+    for (const auto& [key, value] : headers) {
+        list = append_header(list, key, value);
+    }
+    return PreparedHeaders(list);
 }
 
-[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const std::string& body, const std::map<std::string, std::string, std::less<>>& headers) const {
-    return pimpl->performRequest(url, body, std::nullopt, headers);
+PreparedHeaders::~PreparedHeaders() {
+    curl_slist_free_all(m_list);
 }
 
-[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const std::vector<HttpFormPart>& formParts, const std::map<std::string, std::string, std::less<>>& headers) const {
-    return pimpl->performRequest(url, std::nullopt, formParts, headers);
+PreparedHeaders::PreparedHeaders(PreparedHeaders&& other) noexcept : m_list(std::exchange(other.m_list, nullptr)) {}
+
+PreparedHeaders& PreparedHeaders::operator=(PreparedHeaders&& other) noexcept {
+    if (this != &other) {
+        curl_slist_free_all(m_list);
+        m_list = std::exchange(other.m_list, nullptr);
+    }
+    return *this;
+}
+
+// --- Upload streams ---
+
+// Shared by the stream and the transfer uploading it, so either can go away first. The buffer holds
+// the bytes not yet sent from readOffset on; it is compacted in place and never grows past capacity.
+struct HttpUploadStream::State {
+    explicit State(std::size_t bufferCapacity) : capacity(std::max<std::size_t>(bufferCapacity, 1)) {
+        buffer.reserve(capacity);
+    }
+
+    std::mutex mutex;
+    std::condition_variable space;
+    std::string buffer;
+    std::size_t readOffset = 0;
+    const std::size_t capacity;
+    bool attached = false;
+    bool closed = false;
+    bool aborted = false;
+    bool finished = false;
+    // Set while the transfer is paused waiting for data. engine and curl are set while it runs.
+    bool paused = false;
+    MultiEngine* engine = nullptr;
+    CURL* curl = nullptr;
+
+    [[nodiscard]] std::size_t queued() const noexcept { return buffer.size() - readOffset; }
+
+    // Called with the mutex held.
+    void wake_upload() {
+        if (paused && engine) {
+            paused = false;
+            engine->resume(curl);
+        }
+    }
+
+    // Called once the transfer is torn down, so blocked writers give up.
+    void detach() {
+        std::scoped_lock lock(mutex);
+        finished = true;
+        paused = false;
+        engine = nullptr;
+        curl = nullptr;
+        space.notify_all();
+    }
+};
+
+HttpUploadStream::HttpUploadStream(std::size_t capacity) : m_state(std::make_shared<State>(capacity)) {}
+
+// A stream dropped before close() would leave its request paused forever, so it fails the request instead.
+HttpUploadStream::~HttpUploadStream() {
+    std::scoped_lock lock(m_state->mutex);
+    if (!m_state->closed) {
+        m_state->aborted = true;
+        m_state->wake_upload();
+    }
+}
+
+bool HttpUploadStream::write(std::string_view data) {
+    State& state = *m_state;
+    std::unique_lock lock(state.mutex);
+    while (!data.empty()) {
+        state.space.wait(lock, [&state] {
+            return state.queued() < state.capacity || state.closed || state.aborted || state.finished;
+        });
+        if (state.closed || state.aborted || state.finished) {
+            return false;
+        }
+        if (state.readOffset > 0 && state.buffer.size() + data.size() > state.capacity) {
+            state.buffer.erase(0, state.readOffset);
+            state.readOffset = 0;
+        }
+        const std::size_t taken = std::min(data.size(), state.capacity - state.buffer.size());
+        state.buffer.append(data.substr(0, taken));
+        data.remove_prefix(taken);
+        state.wake_upload();
+    }
+    return true;
+}
+
+void HttpUploadStream::close() {
+    std::scoped_lock lock(m_state->mutex);
+    m_state->closed = true;
+    m_state->wake_upload();
+    m_state->space.notify_all();
+}
+
+void HttpUploadStream::abort() {
+    std::scoped_lock lock(m_state->mutex);
+    m_state->aborted = true;
+    m_state->wake_upload();
+    m_state->space.notify_all();
+}
+
+// --- Metrics ---
+
+namespace {
+
+// Log-linear histogram layout: values below 8 get a bucket each, and every higher power of two
+// is split into 8 equal buckets, up to 2^32 microseconds.
+constexpr unsigned LATENCY_SUB_BUCKET_BITS = 3;
+constexpr std::size_t LATENCY_SUB_BUCKETS = std::size_t{1} << LATENCY_SUB_BUCKET_BITS;
+constexpr unsigned LATENCY_MAX_BITS = 32;
+constexpr std::size_t LATENCY_BUCKETS = (LATENCY_MAX_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS;
+// Status classes 1xx to 5xx, plus class 0 for transfers without a response.
+constexpr std::size_t STATUS_CLASSES = 6;
+// Covers every CURLcode libcurl currently defines; larger codes are counted in the last slot.
+constexpr std::size_t MAX_ERROR_CODES = 128;
+
+[[nodiscard]] constexpr std::size_t latency_bucket(std::uint64_t micros) noexcept {
+    micros = std::min<std::uint64_t>(micros, (std::uint64_t{1} << LATENCY_MAX_BITS) - 1);
+    if (micros < LATENCY_SUB_BUCKETS) {
+        return static_cast<std::size_t>(micros);
+    }
+    const auto exponent = static_cast<unsigned>(std::bit_width(micros)) - 1;
+    const unsigned shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    const auto sub_bucket = static_cast<std::size_t>((micros >> shift) & (LATENCY_SUB_BUCKETS - 1));
+    return (shift + 1) * LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+[[nodiscard]] constexpr std::uint64_t latency_bucket_upper_bound(std::size_t index) noexcept {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+    const auto shift = static_cast<unsigned>(index / LATENCY_SUB_BUCKETS - 1);
+    const std::uint64_t lower = (LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+    return lower + (std::uint64_t{1} << shift) - 1;
+}
+
+// Returns the authority of a URL without user info, e.g. "example.com:8443" for "https://user@example.com:8443/path".
+[[nodiscard]] std::string_view url_host(std::string_view url) noexcept {
+    if (const auto scheme_end = url.find("://"); scheme_end != std::string_view::npos) {
+        url.remove_prefix(scheme_end + 3);
+    }
+    url = url.substr(0, url.find_first_of("/?#"));
+    if (const auto at = url.rfind('@'); at != std::string_view::npos) {
+        url.remove_prefix(at + 1);
+    }
+    return url;
+}
+
+// Returns the scheme and authority a URL starts with, e.g. "http://sidecar:8080" for "http://sidecar:8080/v1?q".
+[[nodiscard]] std::string_view url_origin(std::string_view url) noexcept {
+    const auto scheme_end = url.find("://");
+    const std::size_t authority = scheme_end == std::string_view::npos ? 0 : scheme_end + 3;
+    return url.substr(0, url.find_first_of("/?#", authority));
+}
+
+struct TransparentStringHash {
+    using is_transparent = void;
+    [[nodiscard]] std::size_t operator()(std::string_view value) const noexcept { return std::hash<std::string_view>{}(value); }
+};
+
+// Every thread records into its own ThreadStats, whose counters only that thread writes, so the hot
+// path is plain relaxed loads and stores without a lock or a contended cache line. snapshot() sums the
+// threads. A thread's host map is only locked to add a host, which snapshot() may be reading.
+class MetricsRegistry {
+public:
+    MetricsRegistry() : m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)) {}
+
+    void requestStarted() noexcept {
+        add(localStats().inFlight, 1);
+    }
+
+    void requestAbandoned() noexcept {
+        add(localStats().inFlight, -1);
+    }
+
+    // Records a finished request; also ends its in-flight count.
+    void requestFinished(std::string_view host, long statusCode, CURLcode result,
+                         std::chrono::microseconds latency, bool connectionReused) {
+        ThreadStats& stats = localStats();
+        add(stats.inFlight, -1);
+
+        const std::size_t status_class = result == CURLE_OK && statusCode >= 100 && statusCode < 600
+                                             ? static_cast<std::size_t>(statusCode / 100) : 0;
+        const auto micros = static_cast<std::uint64_t>(std::max<std::chrono::microseconds::rep>(latency.count(), 0));
+
+        // Only this thread changes its host map, so it can search it without the lock.
+        auto host_it = stats.hosts.find(host);
+        if (host_it == stats.hosts.end()) {
+            std::scoped_lock lock(stats.hostsMutex);
+            host_it = stats.hosts.emplace(std::string(host), std::make_unique<HostStats>()).first;
+        }
+        std::atomic<Histogram*>& slot = (*host_it->second)[status_class];
+        Histogram* histogram = slot.load(std::memory_order_relaxed);
+        if (!histogram) {
+            histogram = new Histogram();
+            slot.store(histogram, std::memory_order_release);
+        }
+        add(histogram->buckets[latency_bucket(micros)], 1);
+        add(histogram->sumMicros, micros);
+
+        if (result != CURLE_OK) {
+            add(stats.errors[std::min<std::size_t>(static_cast<std::size_t>(result), MAX_ERROR_CODES - 1)], 1);
+        } else if (connectionReused) {
+            add(stats.reusedConnections, 1);
+        } else {
+            add(stats.newConnections, 1);
+        }
+    }
+
+    [[nodiscard]] HttpMetricsSnapshot snapshot() const {
+        HttpMetricsSnapshot snapshot;
+        std::map<std::string, HttpHostMetrics, std::less<>> hosts;
+        std::scoped_lock threads_lock(m_threadsMutex);
+        for (const auto& [thread, stats] : m_threads) {
+            snapshot.inFlight += stats->inFlight.load(std::memory_order_relaxed);
+            snapshot.reusedConnections += stats->reusedConnections.load(std::memory_order_relaxed);
+            snapshot.newConnections += stats->newConnections.load(std::memory_order_relaxed);
+            for (std::size_t code = 0; code < MAX_ERROR_CODES; ++code) {
+                const std::uint64_t errors = stats->errors[code].load(std::memory_order_relaxed);
+                if (errors > 0) snapshot.errorsByCode[static_cast<int>(code)] += errors;
+            }
+            std::scoped_lock hosts_lock(stats->hostsMutex);
+            for (const auto& [host, host_stats] : stats->hosts) {
+                auto& host_metrics = hosts[host];
+                for (std::size_t status_class = 0; status_class < STATUS_CLASSES; ++status_class) {
+                    const Histogram* histogram = (*host_stats)[status_class].load(std::memory_order_acquire);
+                    if (!histogram) continue;
+                    merge(host_metrics.byStatusClass[static_cast<int>(status_class)], *histogram);
+                }
+            }
+        }
+        snapshot.hosts.reserve(hosts.size());
+        for (auto& [host, host_metrics] : hosts) {
+            host_metrics.host = host;
+            snapshot.hosts.push_back(std::move(host_metrics));
+        }
+        return snapshot;
+    }
+
+private:
+    // Registries a thread has recorded into recently; older ones are found again through m_threads.
+    static constexpr std::size_t THREAD_CACHE_SLOTS = 4;
+
+    struct Histogram {
+        std::array<std::atomic<std::uint64_t>, LATENCY_BUCKETS> buckets{};
+        std::atomic<std::uint64_t> sumMicros{0};
+    };
+
+    // Histograms are allocated per status class on first use, so hosts only pay for the classes they return.
+    struct HostStats : std::array<std::atomic<Histogram*>, STATUS_CLASSES> {
+        HostStats() = default;
+        ~HostStats() {
+            for (auto& histogram : *this) delete histogram.load(std::memory_order_relaxed);
+        }
+        HostStats(const HostStats&) = delete;
+        HostStats& operator=(const HostStats&) = delete;
+    };
+
+    struct alignas(64) ThreadStats {
+        std::mutex hostsMutex;
+        std::unordered_map<std::string, std::unique_ptr<HostStats>, TransparentStringHash, std::equal_to<>> hosts;
+        std::array<std::atomic<std::uint64_t>, MAX_ERROR_CODES> errors{};
+        std::atomic<std::uint64_t> reusedConnections{0};
+        std::atomic<std::uint64_t> newConnections{0};
+        // A request may finish on another thread than it started on, so only the sum is meaningful.
+        std::atomic<std::int64_t> inFlight{0};
+    };
+
+    // Each counter has a single writer, so a load and a store replace the locked read-modify-write.
+    template <typename Counter, typename Delta>
+    static void add(std::atomic<Counter>& counter, Delta delta) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + static_cast<Counter>(delta), std::memory_order_relaxed);
+    }
+
+    static void merge(HttpLatencyHistogram& target, const Histogram& source) {
+        target.buckets.resize(LATENCY_BUCKETS);
+        // The count is summed from the buckets read, so it matches them even while requests are being recorded.
+        for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            const std::uint64_t bucket = source.buckets[i].load(std::memory_order_relaxed);
+            target.buckets[i] += bucket;
+            target.count += bucket;
+        }
+        target.sum += std::chrono::microseconds(source.sumMicros.load(std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] ThreadStats& localStats() {
+        struct CachedStats {
+            std::uint64_t registry = 0;
+            ThreadStats* stats = nullptr;
+        };
+        // Keyed by registry id rather than address, so a registry allocated where a destroyed one was never
+        // finds the old entry.
+        thread_local std::array<CachedStats, THREAD_CACHE_SLOTS> cache{};
+        thread_local std::size_t next_slot = 0;
+        for (const CachedStats& cached : cache) {
+            if (cached.registry == m_id) return *cached.stats;
+        }
+        ThreadStats* stats = nullptr;
+        {
+            std::scoped_lock lock(m_threadsMutex);
+            auto& owned = m_threads[std::this_thread::get_id()];
+            if (!owned) owned = std::make_unique<ThreadStats>();
+            stats = owned.get();
+        }
+        cache[next_slot++ % THREAD_CACHE_SLOTS] = {m_id, stats};
+        return *stats;
+    }
+
+    // Ids start at 1, so the zeroed cache slots match no registry.
+    static inline std::atomic<std::uint64_t> s_nextId{1};
+    const std::uint64_t m_id;
+    mutable std::mutex m_threadsMutex;
+    // Kept after their thread exits, so its counts stay in the totals; a later thread with the same id reuses them.
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadStats>> m_threads;
+};
+
+// Appends a Prometheus label value with backslashes, quotes and newlines escaped.
+void append_label_value(std::string& out, std::string_view value) {
+    for (const char c : value) {
+        if (c == '\\' || c == '"') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (c == '\n') {
+            out.append("\\n");
+        } else {
+            out.push_back(c);
+        }
+    }
+}
+
+template <typename Number>
+void append_number(std::string& out, Number value) {
+    std::array<char, 32> buffer{};
+    const auto [end, error] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    out.append(buffer.data(), error == std::errc{} ? end : buffer.data());
+}
+
+void append_metric_header(std::string& out, std::string_view prefix, std::string_view name, std::string_view type, std::string_view help) {
+    out.append("# HELP ").append(prefix).append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(prefix).append(name).append(" ").append(type).append("\n");
+}
+
+[[nodiscard]] std::string_view status_class_label(int status_class) noexcept {
+    static constexpr std::array<std::string_view, STATUS_CLASSES> LABELS{"error", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    return status_class >= 0 && static_cast<std::size_t>(status_class) < LABELS.size() ? LABELS[static_cast<std::size_t>(status_class)] : "error";
+}
+
+} // namespace
+
+[[nodiscard]] std::chrono::microseconds HttpLatencyHistogram::percentile(double quantile) const {
+    if (count == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const double clamped = std::clamp(quantile, 0.0, 1.0);
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(buckets.empty() ? 0 : buckets.size() - 1);
+}
+
+[[nodiscard]] std::chrono::microseconds HttpLatencyHistogram::bucketUpperBound(std::size_t index) {
+    return std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(latency_bucket_upper_bound(std::min(index, LATENCY_BUCKETS - 1))));
+}
+
+[[nodiscard]] double HttpMetricsSnapshot::connectionReuseRatio() const noexcept {
+    const std::uint64_t total = reusedConnections + newConnections;
+    return total == 0 ? 0.0 : static_cast<double>(reusedConnections) / static_cast<double>(total);
+}
+
+[[nodiscard]] std::string HttpMetricsSnapshot::toPrometheus(std::string_view prefix) const {
+    // Exported bucket bounds are powers of two from 256us to about 67s; each covers every smaller latency exactly.
+    static constexpr unsigned FIRST_EXPORTED_POWER = 8;
+    static constexpr unsigned LAST_EXPORTED_POWER = 26;
+    static constexpr double MICROS_PER_SECOND = 1e6;
+
+    std::string out;
+    const std::string name_prefix = prefix.empty() ? std::string() : std::string(prefix) + "_";
+
+    append_metric_header(out, name_prefix, "requests_in_flight", "gauge", "Requests started but not yet finished.");
+    out.append(name_prefix).append("requests_in_flight ");
+    append_number(out, inFlight);
+    out.append("\n");
+
+    append_metric_header(out, name_prefix, "connections_total", "counter", "Finished requests by whether they reused an open connection.");
+    out.append(name_prefix).append("connections_total{reused=\"true\"} ");
+    append_number(out, reusedConnections);
+    out.append("\n").append(name_prefix).append("connections_total{reused=\"false\"} ");
+    append_number(out, newConnections);
+    out.append("\n");
+
+    append_metric_header(out, name_prefix, "errors_total", "counter", "Failed transfers by libcurl error code.");
+    for (const auto& [code, errors] : errorsByCode) {
+        out.append(name_prefix).append("errors_total{code=\"");
+        append_number(out, code);
+        out.append("\",error=\"");
+        append_label_value(out, curl_easy_strerror(static_cast<CURLcode>(code)));
+        out.append("\"} ");
+        append_number(out, errors);
+        out.append("\n");
+    }
+
+    append_metric_header(out, name_prefix, "request_duration_seconds", "histogram", "Request latency by host and status class.");
+    for (const auto& host_metrics : hosts) {
+        for (const auto& [status_class, histogram] : host_metrics.byStatusClass) {
+            std::string labels = "host=\"";
+            append_label_value(labels, host_metrics.host);
+            labels.append("\",status_class=\"").append(status_class_label(status_class)).append("\"");
+
+            const std::string bucket_name = name_prefix + "request_duration_seconds_bucket{";
+            for (unsigned power = FIRST_EXPORTED_POWER; power <= LAST_EXPORTED_POWER; ++power) {
+                // Buckets below this index hold exactly the latencies under 2^power microseconds.
+                const std::size_t end = latency_bucket(std::uint64_t{1} << power);
+                std::uint64_t cumulative = 0;
+                for (std::size_t i = 0; i < end && i < histogram.buckets.size(); ++i) cumulative += histogram.buckets[i];
+                out.append(bucket_name).append(labels).append(",le=\"");
+                append_number(out, static_cast<double>(std::uint64_t{1} << power) / MICROS_PER_SECOND);
+                out.append("\"} ");
+                append_number(out, cumulative);
+                out.append("\n");
+            }
+            out.append(bucket_name).append(labels).append(",le=\"+Inf\"} ");
+            append_number(out, histogram.count);
+            out.append("\n").append(name_prefix).append("request_duration_seconds_sum{").append(labels).append("} ");
+            append_number(out, static_cast<double>(histogram.sum.count()) / MICROS_PER_SECOND);
+            out.append("\n").append(name_prefix).append("request_duration_seconds_count{").append(labels).append("} ");
+            append_number(out, histogram.count);
+            out.append("\n");
+        }
+    }
+    return out;
+}
+
+
+// --- Retries and hedging ---
+
+namespace {
+
+// A token bucket of retries, kept in thousandths of a retry so it fits one lock-free integer.
+class RetryBudget {
+public:
+    RetryBudget(double ratio, double burst) noexcept
+        : m_deposit(to_milli(ratio)), m_capacity(to_milli(burst)), m_balance(m_capacity) {}
+
+    void deposit() noexcept {
+        std::int64_t balance = m_balance.load(std::memory_order_relaxed);
+        while (balance < m_capacity &&
+               !m_balance.compare_exchange_weak(balance, std::min(balance + m_deposit, m_capacity), std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] bool withdraw() noexcept {
+        std::int64_t balance = m_balance.load(std::memory_order_relaxed);
+        while (balance >= MILLI) {
+            if (m_balance.compare_exchange_weak(balance, balance - MILLI, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+private:
+    static constexpr std::int64_t MILLI = 1000;
+    static constexpr double MAX_TOKENS = 1e12;
+
+    [[nodiscard]] static std::int64_t to_milli(double tokens) noexcept {
+        return static_cast<std::int64_t>(std::clamp(tokens, 0.0, MAX_TOKENS) * MILLI);
+    }
+
+    const std::int64_t m_deposit;
+    const std::int64_t m_capacity;
+    std::atomic<std::int64_t> m_balance;
+};
+
+// The latencies of the most recent hedgeable GET requests, from which the hedge delay is derived.
+class LatencyWindow {
+public:
+    void record(std::chrono::microseconds latency) {
+        std::scoped_lock lock(m_mutex);
+        m_samples[m_next] = latency;
+        m_next = (m_next + 1) % WINDOW_SIZE;
+        m_count = std::min(m_count + 1, WINDOW_SIZE);
+    }
+
+    // Returns nothing until enough requests were seen for the percentile to mean something.
+    [[nodiscard]] std::optional<std::chrono::microseconds> percentile(double quantile) const {
+        std::array<std::chrono::microseconds, WINDOW_SIZE> samples{};
+        std::size_t count = 0;
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_count < MIN_SAMPLES) return std::nullopt;
+            samples = m_samples;
+            count = m_count;
+        }
+        const auto rank = std::min(count - 1, static_cast<std::size_t>(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+        const auto nth = samples.begin() + static_cast<std::ptrdiff_t>(rank);
+        std::nth_element(samples.begin(), nth, samples.begin() + static_cast<std::ptrdiff_t>(count));
+        return *nth;
+    }
+
+private:
+    static constexpr std::size_t WINDOW_SIZE = 128;
+    static constexpr std::size_t MIN_SAMPLES = 20;
+
+    mutable std::mutex m_mutex;
+    std::array<std::chrono::microseconds, WINDOW_SIZE> m_samples{};
+    std::size_t m_next = 0;
+    std::size_t m_count = 0;
+};
+
+// Errors after which the request may be sent again because the server never produced a response.
+[[nodiscard]] bool is_transient_error(CURLcode code) noexcept {
+    switch (code) {
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_HTTP2_STREAM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Errors that guarantee no part of the request reached the server, so even a POST can be resent.
+[[nodiscard]] bool is_connect_error(CURLcode code) noexcept {
+    return code == CURLE_COULDNT_RESOLVE_HOST || code == CURLE_COULDNT_CONNECT;
+}
+
+// Whether the outcome of an attempt suggests the host is overloaded, for the adaptive host limits.
+[[nodiscard]] bool looks_overloaded(const std::expected<HttpResponse, CurlError>& outcome) noexcept {
+    return outcome ? outcome->statusCode == 429L || outcome->statusCode == 503L
+                   : is_transient_error(static_cast<CURLcode>(outcome.error().code));
+}
+
+// Where a transfer that failed with the given code stopped.
+[[nodiscard]] HttpErrorPhase error_phase(CURLcode code) noexcept {
+    switch (code) {
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_RESOLVE_PROXY:
+            return HttpErrorPhase::Dns;
+        case CURLE_COULDNT_CONNECT:
+            return HttpErrorPhase::Connect;
+        case CURLE_OPERATION_TIMEDOUT:
+            return HttpErrorPhase::Timeout;
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PEER_FAILED_VERIFICATION:
+        case CURLE_SSL_CERTPROBLEM:
+        case CURLE_SSL_CIPHER:
+        case CURLE_SSL_CACERT_BADFILE:
+        case CURLE_SSL_CRL_BADFILE:
+        case CURLE_SSL_ISSUER_ERROR:
+        case CURLE_SSL_PINNEDPUBKEYNOTMATCH:
+        case CURLE_SSL_INVALIDCERTSTATUS:
+        case CURLE_SSL_CLIENTCERT:
+        case CURLE_SSL_ENGINE_NOTFOUND:
+        case CURLE_SSL_ENGINE_SETFAILED:
+        case CURLE_SSL_ENGINE_INITFAILED:
+        case CURLE_USE_SSL_FAILED:
+            return HttpErrorPhase::Tls;
+        case CURLE_FAILED_INIT:
+        case CURLE_UNSUPPORTED_PROTOCOL:
+        case CURLE_URL_MALFORMAT:
+        case CURLE_NOT_BUILT_IN:
+        case CURLE_OUT_OF_MEMORY:
+        case CURLE_BAD_FUNCTION_ARGUMENT:
+        case CURLE_UNKNOWN_OPTION:
+            return HttpErrorPhase::Setup;
+        default:
+            return HttpErrorPhase::Transfer;
+    }
+}
+
+// Throws the exception the blocking API reports an error with.
+[[noreturn]] void throw_error(const CurlError& error) {
+    switch (error.phase) {
+        case HttpErrorPhase::Overloaded: throw HttpOverloadedException(error.message);
+        case HttpErrorPhase::CircuitOpen: throw HttpCircuitOpenException(error.message);
+        default: throw CurlException(error.message);
+    }
+}
+
+// Reads a Retry-After header given in seconds; the HTTP-date form is ignored.
+[[nodiscard]] std::optional<std::chrono::milliseconds> retry_after(const HttpHeaders& headers) {
+    static constexpr unsigned long MAX_SECONDS = 86400;
+    const auto value = headers.get("Retry-After");
+    if (!value) return std::nullopt;
+    unsigned long seconds = 0;
+    const auto [end, ec] = std::from_chars(value->data(), value->data() + value->size(), seconds);
+    if (ec != std::errc{} || end != value->data() + value->size()) return std::nullopt;
+    return std::chrono::seconds(std::min(seconds, MAX_SECONDS));
+}
+
+// The wait before the given retry (1 for the first one), see HttpRetryPolicy.
+[[nodiscard]] std::chrono::milliseconds retry_backoff(const HttpRetryPolicy& policy, int retry,
+                                                      std::optional<std::chrono::milliseconds> serverDelay) {
+    const auto cap = static_cast<double>(std::max(policy.maxBackoff.count(), std::chrono::milliseconds::rep{0}));
+    double backoff = static_cast<double>(policy.initialBackoff.count()) * std::pow(policy.backoffMultiplier, retry - 1);
+    backoff = std::clamp(std::isnan(backoff) ? cap : backoff, 0.0, cap);
+    if (policy.jitter) {
+        thread_local std::minstd_rand generator{std::random_device{}()};
+        backoff = std::uniform_real_distribution<double>(0.0, backoff)(generator);
+    }
+    if (serverDelay) {
+        backoff = std::max(backoff, std::min(static_cast<double>(serverDelay->count()), cap));
+    }
+    return std::chrono::milliseconds(std::llround(backoff));
+}
+
+} // namespace
+
+
+// --- Host limits ---
+
+namespace {
+
+// The concurrency limit of one host: a counting semaphore with a bounded wait queue, whose size
+// optionally follows the host's health (additive increase, multiplicative decrease).
+class HostLimiter {
+public:
+    explicit HostLimiter(const HttpHostLimits& limits)
+        : m_limits(limits), m_limit(static_cast<double>(limits.maxConcurrent)) {}
+
+    // Takes a slot only if one is free right now, without queueing.
+    [[nodiscard]] bool try_acquire() {
+        std::scoped_lock lock(m_mutex);
+        if (m_waiting > 0 || !has_capacity()) {
+            return false;
+        }
+        ++m_inFlight;
+        return true;
+    }
+
+    // Takes a slot, waiting in the queue if there is room. Returns false if the request must be shed.
+    [[nodiscard]] bool acquire() {
+        std::unique_lock lock(m_mutex);
+        if (m_waiting == 0 && has_capacity()) {
+            ++m_inFlight;
+            return true;
+        }
+        if (m_waiting >= m_limits.maxQueued) {
+            return false;
+        }
+        ++m_waiting;
+        const bool admitted = m_released.wait_for(lock, m_limits.maxQueueWait, [this] { return has_capacity(); });
+        --m_waiting;
+        if (!admitted) {
+            return false;
+        }
+        ++m_inFlight;
+        return true;
+    }
+
+    // Frees a slot. sample holds the attempt's latency and whether the host looked overloaded,
+    // and is empty when the attempt ended in a way that says nothing about the host.
+    void release(std::optional<std::pair<std::chrono::microseconds, bool>> sample) {
+        std::scoped_lock lock(m_mutex);
+        const std::size_t in_flight = m_inFlight--;
+        if (m_limits.adaptive && sample) {
+            adapt(sample->first, sample->second, in_flight);
+        }
+        m_released.notify_all();
+    }
+
+private:
+    // Weights of the short- and long-term latency averages, roughly the last 10 and 100 requests.
+    static constexpr double SHORT_WEIGHT = 0.1;
+    static constexpr double LONG_WEIGHT = 0.01;
+
+    [[nodiscard]] bool has_capacity() const noexcept {
+        return static_cast<double>(m_inFlight) < std::floor(m_limit);
+    }
+
+    void adapt(std::chrono::microseconds latency, bool failed, std::size_t inFlight) {
+        const auto micros = static_cast<double>(latency.count());
+        if (m_longLatency == 0.0) {
+            m_shortLatency = m_longLatency = micros;
+        } else {
+            m_shortLatency += SHORT_WEIGHT * (micros - m_shortLatency);
+            m_longLatency += LONG_WEIGHT * (micros - m_longLatency);
+        }
+
+        const auto ceiling = static_cast<double>(m_limits.maxConcurrent);
+        const auto floor = std::clamp(static_cast<double>(m_limits.adaptiveMinLimit), 1.0, ceiling);
+        const auto now = std::chrono::steady_clock::now();
+        if (failed || m_shortLatency > m_limits.latencyTolerance * m_longLatency) {
+            // Requests that were already in flight report the same congestion, so shrink once per round trip.
+            if (now - m_lastDecrease >= latency) {
+                m_limit = std::max(floor, m_limit * std::clamp(m_limits.decreaseFactor, 0.0, 1.0));
+                m_lastDecrease = now;
+            }
+        } else if (2 * inFlight >= static_cast<std::size_t>(m_limit)) {
+            // Only grow while the limit is actually being used, so an idle host cannot build up credit.
+            m_limit = std::min(ceiling, m_limit + 1.0 / m_limit);
+        }
+    }
+
+    const HttpHostLimits& m_limits;
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::size_t m_inFlight = 0;
+    std::size_t m_waiting = 0;
+    double m_limit;
+    double m_shortLatency = 0.0;
+    double m_longLatency = 0.0;
+    std::chrono::steady_clock::time_point m_lastDecrease{};
+};
+
+// Per-host state built from the client's policy, created on first use and never removed.
+template <typename State, typename Policy>
+class HostTable {
+public:
+    explicit HostTable(const Policy& policy) : m_policy(policy) {}
+
+    [[nodiscard]] State& forHost(std::string_view host) {
+        {
+            std::shared_lock lock(m_mutex);
+            if (const auto it = m_hosts.find(host); it != m_hosts.end()) return *it->second;
+        }
+        std::scoped_lock lock(m_mutex);
+        auto [it, inserted] = m_hosts.try_emplace(std::string(host), nullptr);
+        if (inserted) it->second = std::make_unique<State>(m_policy);
+        return *it->second;
+    }
+
+private:
+    const Policy& m_policy;
+    std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<State>, TransparentStringHash, std::equal_to<>> m_hosts;
+};
+
+using HostLimiters = HostTable<HostLimiter, HttpHostLimits>;
+
+// Closed, open and half-open states of one host, with the failure rate counted in time buckets.
+class CircuitBreaker {
+public:
+    enum class Admission { Rejected, Normal, Probe };
+
+    explicit CircuitBreaker(const HttpCircuitBreakerPolicy& policy)
+        : m_policy(policy),
+          m_bucketWidth(std::max<std::chrono::steady_clock::duration>(policy.window / static_cast<int>(BUCKETS),
+                                                                      std::chrono::steady_clock::duration{1})) {}
+
+    [[nodiscard]] Admission admit() {
+        std::scoped_lock lock(m_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (m_state == State::Open && now - m_openedAt >= m_policy.openDuration) {
+            m_state = State::HalfOpen;
+            m_probeSuccesses = 0;
+        }
+        switch (m_state) {
+            case State::Closed:
+                return Admission::Normal;
+            case State::HalfOpen:
+                if (m_probing) return Admission::Rejected;
+                m_probing = true;
+                return Admission::Probe;
+            default:
+                return Admission::Rejected;
+        }
+    }
+
+    // Reports the outcome of an admitted attempt.
+    void record(Admission admission, bool failed) {
+        std::scoped_lock lock(m_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (admission == Admission::Probe) {
+            m_probing = false;
+            if (failed) {
+                open(now);
+            } else if (++m_probeSuccesses >= m_policy.halfOpenProbes) {
+                m_state = State::Closed;
+                m_buckets = {};
+            }
+            return;
+        }
+        // Attempts that were already running when the breaker opened say nothing new.
+        if (m_state != State::Closed) return;
+
+        const std::int64_t slot = (now - std::chrono::steady_clock::time_point{}) / m_bucketWidth;
+        Bucket& bucket = m_buckets[static_cast<std::size_t>(slot % static_cast<std::int64_t>(BUCKETS))];
+        if (bucket.slot != slot) bucket = Bucket{.slot = slot};
+        ++bucket.attempts;
+        if (failed) ++bucket.failures;
+        if (!failed) return;
+
+        std::uint64_t attempts = 0;
+        std::uint64_t failures = 0;
+        for (const Bucket& recent : m_buckets) {
+            if (slot - recent.slot >= static_cast<std::int64_t>(BUCKETS)) continue;
+            attempts += recent.attempts;
+            failures += recent.failures;
+        }
+        if (attempts >= std::max<std::size_t>(m_policy.minimumRequests, 1) &&
+            static_cast<double>(failures) >= m_policy.failureRateThreshold * static_cast<double>(attempts)) {
+            open(now);
+        }
+    }
+
+    // Gives back an admission whose attempt ended without an outcome, e.g. because a body sink threw.
+    void abandon(Admission admission) {
+        if (admission != Admission::Probe) return;
+        std::scoped_lock lock(m_mutex);
+        m_probing = false;
+    }
+
+private:
+    static constexpr std::size_t BUCKETS = 10;
+
+    enum class State { Closed, Open, HalfOpen };
+
+    struct Bucket {
+        std::int64_t slot = -1;
+        std::uint64_t attempts = 0;
+        std::uint64_t failures = 0;
+    };
+
+    void open(std::chrono::steady_clock::time_point now) {
+        m_state = State::Open;
+        m_openedAt = now;
+        m_buckets = {};
+    }
+
+    const HttpCircuitBreakerPolicy& m_policy;
+    const std::chrono::steady_clock::duration m_bucketWidth;
+    std::mutex m_mutex;
+    State m_state = State::Closed;
+    std::array<Bucket, BUCKETS> m_buckets{};
+    std::chrono::steady_clock::time_point m_openedAt{};
+    bool m_probing = false;
+    std::size_t m_probeSuccesses = 0;
+};
+
+using CircuitBreakers = HostTable<CircuitBreaker, HttpCircuitBreakerPolicy>;
+
+// Lets one attempt through a host's circuit breaker and reports how it ended. Rejected attempts
+// are reported by admitted() rather than thrown, as an open breaker can reject every request.
+class CircuitPass {
+public:
+    explicit CircuitPass(CircuitBreaker& breaker) : m_breaker(&breaker), m_admission(breaker.admit()) {}
+    ~CircuitPass() {
+        if (m_failed) {
+            m_breaker->record(m_admission, *m_failed);
+        } else {
+            m_breaker->abandon(m_admission);
+        }
+    }
+    CircuitPass(const CircuitPass&) = delete;
+    CircuitPass& operator=(const CircuitPass&) = delete;
+
+    [[nodiscard]] bool admitted() const noexcept { return m_admission != CircuitBreaker::Admission::Rejected; }
+    void record(bool failed) noexcept { m_failed = failed; }
+
+private:
+    CircuitBreaker* m_breaker;
+    CircuitBreaker::Admission m_admission;
+    std::optional<bool> m_failed;
+};
+
+// Holds a host slot for one attempt and hands the attempt's outcome to the limiter when released.
+// A request that was shed holds no slot, see acquired().
+class HostSlot {
+public:
+    explicit HostSlot(HostLimiter& limiter) : m_limiter(&limiter), m_acquired(limiter.acquire()) {}
+    HostSlot(HostLimiter& limiter, std::try_to_lock_t) : m_limiter(&limiter), m_acquired(limiter.try_acquire()) {}
+    ~HostSlot() {
+        if (m_acquired) m_limiter->release(m_sample);
+    }
+    HostSlot(const HostSlot&) = delete;
+    HostSlot& operator=(const HostSlot&) = delete;
+
+    [[nodiscard]] bool acquired() const noexcept { return m_acquired; }
+    void record(std::chrono::microseconds latency, bool overloaded) noexcept { m_sample.emplace(latency, overloaded); }
+
+private:
+    HostLimiter* m_limiter;
+    bool m_acquired;
+    std::optional<std::pair<std::chrono::microseconds, bool>> m_sample;
+};
+
+} // namespace
+
+// --- Response cache ---
+
+namespace {
+
+constexpr std::size_t CACHE_SHARDS = 16;
+// Rough bookkeeping cost of an entry beyond its text, so many tiny responses still count against the budget.
+constexpr std::size_t CACHE_ENTRY_OVERHEAD = 256;
+// Caps parsed max-age and Age values (one year), so adding them to a time point cannot overflow.
+constexpr std::uint64_t CACHE_MAX_SECONDS = 31536000;
+
+// The Cache-Control directives the cache acts on.
+struct CacheDirectives {
+    bool noStore = false;
+    bool noCache = false;
+    std::optional<std::chrono::seconds> maxAge;
+};
+
+[[nodiscard]] std::optional<std::chrono::seconds> parse_seconds(std::string_view text) {
+    std::uint64_t seconds = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+    if (ec != std::errc{} || end != text.data() + text.size()) return std::nullopt;
+    return std::chrono::seconds(std::min(seconds, CACHE_MAX_SECONDS));
+}
+
+[[nodiscard]] CacheDirectives parse_cache_control(std::string_view value) {
+    CacheDirectives directives;
+    while (!value.empty()) {
+        const size_t comma = value.find(',');
+        const std::string_view directive = value.substr(0, comma);
+        value = comma == std::string_view::npos ? std::string_view{} : value.substr(comma + 1);
+
+        const size_t equals = directive.find('=');
+        const std::string_view name = trim(directive.substr(0, equals), HEADER_WHITESPACE, HEADER_WHITESPACE);
+        if (header_name_equal(name, "no-store")) {
+            directives.noStore = true;
+        } else if (header_name_equal(name, "no-cache")) {
+            directives.noCache = true;
+        } else if (header_name_equal(name, "max-age") && equals != std::string_view::npos) {
+            directives.maxAge = parse_seconds(trim(directive.substr(equals + 1), " \t\"", " \t\""));
+        }
+    }
+    return directives;
+}
+
+// A stored response and the request header values it was selected by (see Vary). Immutable once stored.
+struct CacheEntry {
+    std::string url;
+    std::vector<std::pair<std::string, std::optional<std::string>>> vary;
+    HttpResponse response;
+    std::size_t bytes = 0;
+};
+
+// When a stored response stops being fresh, and whether it must be revalidated before every use.
+struct CacheFreshness {
+    std::chrono::steady_clock::time_point expires;
+    bool noCache = false;
+};
+
+[[nodiscard]] CacheFreshness response_freshness(const HttpHeaders& headers, std::chrono::steady_clock::time_point now) {
+    const auto cache_control = headers.get("Cache-Control");
+    const CacheDirectives directives = cache_control ? parse_cache_control(*cache_control) : CacheDirectives{};
+    const auto age_header = headers.get("Age");
+    const std::chrono::seconds age = age_header ? parse_seconds(*age_header).value_or(std::chrono::seconds{0}) : std::chrono::seconds{0};
+    const std::chrono::seconds lifetime = std::max(directives.maxAge.value_or(std::chrono::seconds{0}) - age, std::chrono::seconds{0});
+    return {.expires = now + lifetime, .noCache = directives.noCache};
+}
+
+// An in-memory LRU cache of GET responses, split into independently locked shards by URL.
+// Each shard holds an equal part of the byte budget.
+class ResponseCache {
+public:
+    struct Hit {
+        std::shared_ptr<const CacheEntry> entry;
+        bool fresh = false;
+    };
+
+    explicit ResponseCache(std::size_t maxBytes) : m_shardCapacity(maxBytes / CACHE_SHARDS) {}
+
+    // Finds the variant of the URL whose Vary values match the request. requestHeader maps a header
+    // name to the value the request sends, if any.
+    template <typename RequestHeader>
+    [[nodiscard]] std::optional<Hit> find(std::string_view url, const RequestHeader& requestHeader) {
+        Shard& shard = shard_for(url);
+        std::scoped_lock lock(shard.mutex);
+        const auto variants = shard.byUrl.find(url);
+        if (variants == shard.byUrl.end()) return std::nullopt;
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto slot : variants->second) {
+            const bool selected = std::ranges::all_of(slot->entry->vary, [&requestHeader](const auto& header) {
+                return requestHeader(header.first) == header.second;
+            });
+            if (!selected) continue;
+            shard.lru.splice(shard.lru.begin(), shard.lru, slot);
+            return Hit{.entry = slot->entry, .fresh = !slot->freshness.noCache && now < slot->freshness.expires};
+        }
+        return std::nullopt;
+    }
+
+    // Stores a response, replacing the variant with the same Vary values and evicting the least recently used entries.
+    void store(std::shared_ptr<const CacheEntry> entry, CacheFreshness freshness) {
+        // An entry larger than its shard's share of the budget is never kept (see HttpClientConfig::responseCacheBytes).
+        if (entry->bytes > m_shardCapacity) return;
+        Shard& shard = shard_for(entry->url);
+        std::scoped_lock lock(shard.mutex);
+        if (const auto variants = shard.byUrl.find(entry->url); variants != shard.byUrl.end()) {
+            const auto same = std::ranges::find_if(variants->second, [&entry](const auto slot) { return slot->entry->vary == entry->vary; });
+            if (same != variants->second.end()) erase(shard, *same);
+        }
+        shard.bytes += entry->bytes;
+        shard.lru.push_front(Slot{.entry = entry, .freshness = freshness});
+        shard.byUrl[entry->url].push_back(shard.lru.begin());
+        while (shard.bytes > m_shardCapacity) {
+            erase(shard, std::prev(shard.lru.end()));
+        }
+    }
+
+    // Renews a stored entry after the server confirmed it with 304 Not Modified.
+    void renew(const std::shared_ptr<const CacheEntry>& entry, CacheFreshness freshness) {
+        Shard& shard = shard_for(entry->url);
+        std::scoped_lock lock(shard.mutex);
+        const auto variants = shard.byUrl.find(entry->url);
+        if (variants == shard.byUrl.end()) return;
+        const auto slot = std::ranges::find_if(variants->second, [&entry](const auto candidate) { return candidate->entry == entry; });
+        if (slot != variants->second.end()) (*slot)->freshness = freshness;
+    }
+
+    // Drops every variant of a URL, e.g. after an unsafe request to it.
+    void invalidate(std::string_view url) {
+        Shard& shard = shard_for(url);
+        std::scoped_lock lock(shard.mutex);
+        while (true) {
+            const auto variants = shard.byUrl.find(url);
+            if (variants == shard.byUrl.end()) return;
+            erase(shard, variants->second.back());
+        }
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<const CacheEntry> entry;
+        CacheFreshness freshness;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        // Most recently used first.
+        std::list<Slot> lru;
+        std::unordered_map<std::string, std::vector<std::list<Slot>::iterator>, TransparentStringHash, std::equal_to<>> byUrl;
+        std::size_t bytes = 0;
+    };
+
+    [[nodiscard]] Shard& shard_for(std::string_view url) noexcept {
+        return m_shards[std::hash<std::string_view>{}(url) % CACHE_SHARDS];
+    }
+
+    static void erase(Shard& shard, std::list<Slot>::iterator slot) {
+        const auto variants = shard.byUrl.find(slot->entry->url);
+        std::erase(variants->second, slot);
+        if (variants->second.empty()) shard.byUrl.erase(variants);
+        shard.bytes -= slot->entry->bytes;
+        shard.lru.erase(slot);
+    }
+
+    const std::size_t m_shardCapacity;
+    std::array<Shard, CACHE_SHARDS> m_shards;
+};
+
+// --- Segmented downloads ---
+
+// The file a segmented download writes to, at arbitrary offsets.
+class DownloadFile {
+public:
+    explicit DownloadFile(const std::string& path) {
+#ifdef _WIN32
+        if (_sopen_s(&m_fd, path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) {
+            m_fd = -1;
+        }
+#else
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+        if (m_fd < 0) {
+            throw CurlException("Failed to open the download file: " + path);
+        }
+    }
+    ~DownloadFile() {
+#ifdef _WIN32
+        _close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+    }
+    DownloadFile(const DownloadFile&) = delete;
+    DownloadFile& operator=(const DownloadFile&) = delete;
+
+    [[nodiscard]] int fd() const noexcept { return m_fd; }
+
+    [[nodiscard]] std::uint64_t size() const noexcept {
+#ifdef _WIN32
+        const auto length = _filelengthi64(m_fd);
+        return length < 0 ? 0 : static_cast<std::uint64_t>(length);
+#else
+        struct stat info{};
+        return fstat(m_fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+#endif
+    }
+
+    // Sets the file size and, where supported, reserves its blocks up front so parallel writes do not fragment it.
+    void resize(std::uint64_t size) const {
+#ifdef _WIN32
+        const bool resized = _chsize_s(m_fd, static_cast<__int64>(size)) == 0;
+#else
+        const bool resized = ftruncate(m_fd, static_cast<off_t>(size)) == 0;
+#ifdef __linux__
+        if (resized && size > 0) {
+            // Best effort: file systems without fallocate support still work, just without the reservation.
+            static_cast<void>(posix_fallocate(m_fd, 0, static_cast<off_t>(size)));
+        }
+#endif
+#endif
+        if (!resized) {
+            throw CurlException("Failed to resize the download file.");
+        }
+    }
+
+    // Writes at an absolute offset. On Windows the offset is set with a seek, which is safe because
+    // all segments of a download are written from the event loop thread.
+    [[nodiscard]] bool write_at(std::uint64_t offset, std::span<const char> data) const noexcept {
+        while (!data.empty()) {
+#ifdef _WIN32
+            if (_lseeki64(m_fd, static_cast<__int64>(offset), SEEK_SET) < 0) return false;
+            const auto written = _write(m_fd, data.data(), static_cast<unsigned int>(data.size()));
+#else
+            const auto written = pwrite(m_fd, data.data(), data.size(), static_cast<off_t>(offset));
+#endif
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            offset += static_cast<std::uint64_t>(written);
+            data = data.subspan(static_cast<std::size_t>(written));
+        }
+        return true;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+// One byte range [begin, end) of a download. written is advanced on the loop thread after every chunk
+// is in the file and read by the calling thread when it saves the progress.
+struct DownloadSegment {
+    std::uint64_t begin = 0;
+    std::uint64_t end = 0;
+    std::atomic<std::uint64_t> written{0};
+    int attempts = 0;
+    std::uint64_t ticket = 0;
+    bool done = false;
+
+    [[nodiscard]] std::uint64_t remaining() const noexcept { return end - begin - written.load(std::memory_order_acquire); }
+};
+
+constexpr std::string_view DOWNLOAD_PROGRESS_MAGIC = "httpcli-download 1";
+
+[[nodiscard]] std::optional<std::uint64_t> parse_uint64(std::string_view text) noexcept {
+    std::uint64_t value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// The progress file holds the object size and validator, then one "begin end written" line per segment.
+// It is replaced atomically, so an interrupted save leaves the previous progress intact. Written counts
+// are taken after the bytes reached the file, so a stale file only makes a resume fetch some bytes twice.
+void save_download_progress(const std::string& progressPath, std::uint64_t size, std::string_view validator,
+                            const std::vector<DownloadSegment>& segments) noexcept {
+    if (progressPath.empty()) return;
+    try {
+        std::string contents(DOWNLOAD_PROGRESS_MAGIC);
+        contents.append("\n");
+        append_number(contents, size);
+        contents.append("\n").append(validator).append("\n");
+        for (const DownloadSegment& segment : segments) {
+            append_number(contents, segment.begin);
+            contents.append(" ");
+            append_number(contents, segment.end);
+            contents.append(" ");
+            append_number(contents, segment.written.load(std::memory_order_acquire));
+            contents.append("\n");
+        }
+        const std::string temporary = progressPath + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file << contents;
+            if (!file.flush()) return;
+        }
+        std::error_code ignored;
+        std::filesystem::rename(temporary, progressPath, ignored);
+    } catch (...) { // NOSONAR: losing the progress only costs a full download later
+    }
+}
+
+// Restores the segments of an earlier download of the same object, or returns nothing if there is
+// no usable progress file.
+[[nodiscard]] std::optional<std::vector<std::array<std::uint64_t, 3>>> load_download_progress(
+        const std::string& progressPath, std::uint64_t size, std::string_view validator) {
+    std::ifstream file(progressPath, std::ios::binary);
+    std::string line;
+    if (!std::getline(file, line) || line != DOWNLOAD_PROGRESS_MAGIC) return std::nullopt;
+    if (!std::getline(file, line) || parse_uint64(line) != size) return std::nullopt;
+    if (!std::getline(file, line) || line != validator) return std::nullopt;
+
+    std::vector<std::array<std::uint64_t, 3>> segments;
+    std::uint64_t expected_begin = 0;
+    while (std::getline(file, line)) {
+        std::array<std::uint64_t, 3> segment{};
+        std::string_view rest = line;
+        for (std::size_t i = 0; i < segment.size(); ++i) {
+            const std::size_t space = i + 1 < segment.size() ? rest.find(' ') : rest.size();
+            if (space == std::string_view::npos) return std::nullopt;
+            const auto value = parse_uint64(rest.substr(0, space));
+            if (!value) return std::nullopt;
+            segment[i] = *value;
+            rest.remove_prefix(std::min(space + 1, rest.size()));
+        }
+        // The ranges must tile the object in order, with plausible progress.
+        if (segment[0] != expected_begin || segment[1] <= segment[0] || segment[2] > segment[1] - segment[0]) return std::nullopt;
+        expected_begin = segment[1];
+        segments.push_back(segment);
+    }
+    if (segments.empty() || expected_begin != size) return std::nullopt;
+    return segments;
+}
+
+// --- TLS material ---
+
+// Reads a certificate or key file once, so requests hand it to libcurl from memory instead of reopening it.
+[[nodiscard]] std::string read_tls_file(const std::optional<std::string>& path, const char* what) {
+    if (!path) {
+        return {};
+    }
+    std::ifstream file(*path, std::ios::binary);
+    std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (!file.good() && !file.eof()) {
+        throw CurlException(std::string("Failed to read the ") + what + " file: " + *path);
+    }
+    if (contents.empty()) {
+        throw CurlException(std::string("The ") + what + " file is missing or empty: " + *path);
+    }
+    return contents;
+}
+
+// Points a libcurl blob option at memory owned by the client, which outlives every handle it is set on.
+void set_tls_blob(/* NOSONAR */ CURL* curl, CURLoption option, const std::string& contents) {
+    if (contents.empty()) {
+        return;
+    }
+    curl_blob blob{const_cast<char*>(contents.data()), contents.size(), CURL_BLOB_NOCOPY};
+    curl_easy_setopt(curl, option, &blob);
+}
+
+[[nodiscard]] long tls_version_option(HttpTlsVersion version) noexcept {
+    return version == HttpTlsVersion::Tls1_3 ? CURL_SSLVERSION_TLSv1_3 : CURL_SSLVERSION_TLSv1_2;
+}
+
+[[nodiscard]] long tls_max_version_option(HttpTlsVersion version) noexcept {
+    return version == HttpTlsVersion::Tls1_3 ? CURL_SSLVERSION_MAX_TLSv1_3 : CURL_SSLVERSION_MAX_TLSv1_2;
+}
+
+} // namespace
+
+// Private implementation of the HttpClient.
+class HttpClient::Impl {
+public:
+    explicit Impl(HttpClientConfig config)
+        : m_config(std::move(config)),
+          m_defaultHeaders(PreparedHeaders::fromMap(m_config.defaultHeaders)),
+          m_metrics(m_config.enableMetrics ? std::make_unique<MetricsRegistry>() : nullptr),
+          m_retryBudget(m_config.retry.budgetRatio, m_config.retry.budgetBurst),
+          m_hostLimiters(m_config.hostLimits.maxConcurrent > 0 ? std::make_unique<HostLimiters>(m_config.hostLimits) : nullptr),
+          m_circuitBreakers(m_config.circuitBreaker.enabled ? std::make_unique<CircuitBreakers>(m_config.circuitBreaker) : nullptr),
+          m_cache(m_config.responseCacheBytes > 0 ? std::make_unique<ResponseCache>(m_config.responseCacheBytes) : nullptr),
+          m_clientCert(read_tls_file(m_config.clientCertPath, "client certificate")),
+          m_clientKey(read_tls_file(m_config.clientKeyPath, "client key")),
+          m_caCerts(read_tls_file(m_config.caCertPath, "CA certificate")),
+          m_share(m_config),
+          m_handlePool(m_config.handlePoolSize) {
+        if (m_config.tlsMaxVersion && *m_config.tlsMaxVersion < m_config.tlsMinVersion) {
+            throw CurlException("tlsMaxVersion must not be older than tlsMinVersion.");
+        }
+        if (std::ranges::find(m_config.scheduler.weights, 0U) != m_config.scheduler.weights.end()) {
+            throw CurlException("Scheduler weights must be at least 1.");
+        }
+        if (m_config.hostLimits.adaptive && m_config.hostLimits.maxConcurrent == 0) {
+            throw CurlException("Adaptive host limits require hostLimits.maxConcurrent.");
+        }
+        for (const std::string& pin : m_config.resolve) {
+            curl_slist* appended = curl_slist_append(m_resolve.get(), pin.c_str());
+            if (!appended) {
+                throw CurlException("curl_slist_append() failed.");
+            }
+            // The returned head owns the entries already held, so ownership moves over without a free.
+            static_cast<void>(m_resolve.release());
+            m_resolve.reset(appended);
+        }
+#ifndef HTTPCLIENT_WITH_ZLIB
+        if (m_config.compressRequestsAbove > 0) {
+            throw CurlException("compressRequestsAbove requires a build with zlib (HTTPCLIENT_WITH_ZLIB).");
+        }
+#endif
+    }
+
+    // Where a transfer delivers its response body. By default it is buffered into HttpResponse::body.
+    struct BodyOutput {
+        const HttpBodySink* sink = nullptr;
+        std::optional<int> fd;
+        // Stops the transfer unless the response is 206 Partial Content, so the body of a range
+        // request the server ignored never reaches the output. The response is still returned, with
+        // its status code and an empty body, so the caller can tell why.
+        bool partialOnly = false;
+    };
+
+    // Describes one request in terms of the caller's arguments, which only need to stay
+    // alive for the duration of the call that receives the spec. Null members are unused.
+    struct RequestSpec {
+        const std::string& url;
+        const std::map<std::string, std::string, std::less<>>& headers;
+        std::optional<std::string_view> body{};
+        const HttpBodySource* source = nullptr;
+        const std::vector<HttpFormPart>* formParts = nullptr;
+        HttpUploadStream* upload = nullptr;
+        const PreparedHeaders* preparedHeaders = nullptr;
+        BodyOutput output{};
+        // A response whose body and header storage the blocking transfer reuses. Its contents are
+        // discarded and its buffers move into the result (or back into it on failure).
+        HttpResponse* reuse = nullptr;
+        // Sends HEAD instead of GET.
+        bool head = false;
+        // The scheduling class of an asynchronous request.
+        HttpPriority priority = HttpPriority::Normal;
+    };
+
+    [[nodiscard]] HttpResponse performRequest(const RequestSpec& spec) const;
+
+    // Like performRequest, but returns every failure, including one to set up the request, instead of throwing it.
+    [[nodiscard]] std::expected<HttpResponse, CurlError> tryPerformRequest(const RequestSpec& spec) const;
+
+    // Runs a buffered GET, or waits for the identical one already in flight and shares its response.
+    [[nodiscard]] std::expected<std::shared_ptr<const HttpResponse>, CurlError> performShared(const RequestSpec& spec) const;
+
+    // Starts the request on the client's event loop. A provided ownedBody replaces spec.body and is
+    // kept alive until the transfer finishes. onComplete runs on the loop thread, or on the calling
+    // thread if the request cannot be set up. Returns the engine ticket, or 0 if it was not submitted.
+    std::uint64_t performRequestAsync(const RequestSpec& spec,
+                             std::optional<std::string> ownedBody,
+                             HttpCompletionHandler onComplete) const;
+
+    [[nodiscard]] std::vector<std::expected<HttpResponse, CurlError>> performBatch(std::span<const HttpRequest> requests) const;
+
+    [[nodiscard]] std::vector<std::expected<void, CurlError>> warmup(std::span<const std::string> origins, std::size_t connectionsPerOrigin) const;
+    [[nodiscard]] HttpDownloadResult download(const std::string& url, const std::string& path, const HttpDownloadOptions& options) const;
+    void fetch_segments(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers,
+                        std::string_view validator, int maxAttempts, HttpPriority priority, const DownloadFile& file,
+                        std::vector<DownloadSegment>& segments, const std::string& progressPath, std::uint64_t size) const;
+
+    [[nodiscard]] HttpMetricsSnapshot metrics() const {
+        return m_metrics ? m_metrics->snapshot() : HttpMetricsSnapshot{};
+    }
+
+    // Builds a header list from the client's default headers overlaid with the given ones.
+    [[nodiscard]] curl_slist* build_headers(const std::map<std::string, std::string, std::less<>>& headers) const;
+
+private:
+    struct SlistDeleter {
+        void operator()(curl_slist* list) const noexcept { curl_slist_free_all(list); }
+    };
+    struct MimeDeleter {
+        void operator()(curl_mime* mime) const noexcept { curl_mime_free(mime); }
+    };
+
+    struct Transfer;
+
+    // State behind a multipart part that libcurl reads through curl_mime_data_cb:
+    // either a caller-owned buffer with a read position, or a copy of the part's generator.
+    struct FormPartReader {
+        Transfer* transfer = nullptr;
+        std::span<const std::byte> buffer;
+        std::size_t offset = 0;
+        HttpBodySource generator;
+    };
+
+    // Owns every libcurl resource needed for the lifetime of one transfer.
+    // The handle is declared first so it is returned to the pool only after
+    // the header list and MIME form are freed.
+    struct Transfer {
+        explicit Transfer(CurlHandlePool& pool) : handle(pool.acquire(), PooledHandleReleaser{&pool}) {}
+        Transfer(const Transfer&) = delete;
+        Transfer& operator=(const Transfer&) = delete;
+        // A transfer dropped before it finished (e.g. when a batch unwinds) still leaves the in-flight gauge.
+        ~Transfer() {
+            if (metricsPending) metrics->requestAbandoned();
+            if (upload) upload->detach();
+        }
+        PooledHandle handle;
+        std::unique_ptr<curl_slist, SlistDeleter> headerList;
+        std::unique_ptr<curl_mime, MimeDeleter> mime;
+        // Address-stable readers for streamed multipart parts, so asynchronous transfers never reference caller state.
+        std::vector<FormPartReader> formReaders;
+        // Keeps the request body alive for asynchronous transfers, since CURLOPT_POSTFIELDS does not copy it.
+        std::string ownedBody;
+        // The gzip-compressed request body, when compressRequestsAbove applies.
+        std::string compressedBody;
+        HttpResponse response;
+        BodyOutput output;
+        // Upper bound for the body size, taken from HttpClientConfig::maxBodyBytes (0 = unlimited).
+        std::size_t maxBodyBytes = 0;
+        std::size_t bodyBytes = 0;
+        // Set when the body output stopped the transfer, so the failure can be reported accurately.
+        bool outputAborted = false;
+        bool bodyLimitExceeded = false;
+        // Set when partialOnly stopped a response that was not 206; the transfer then counts as completed.
+        bool rangeIgnored = false;
+        // Exception thrown by a body sink or source, rethrown once the transfer has been torn down.
+        std::exception_ptr callbackError;
+        const HttpBodySource* source = nullptr;
+        bool sourceFailed = false;
+        // The stream an HttpUploadStream request reads its body from.
+        std::shared_ptr<HttpUploadStream::State> upload;
+        // Set while the transfer counts as in flight in the client's metrics.
+        MetricsRegistry* metrics = nullptr;
+        bool metricsPending = false;
+    };
+
+    HttpClientConfig m_config;
+    PreparedHeaders m_defaultHeaders;
+    // Null unless HttpClientConfig::enableMetrics is set. Declared before the engine, whose shutdown still records aborted transfers.
+    std::unique_ptr<MetricsRegistry> m_metrics;
+    mutable RetryBudget m_retryBudget;
+    mutable LatencyWindow m_getLatencies;
+    // Null unless HttpHostLimits::maxConcurrent is set.
+    std::unique_ptr<HostLimiters> m_hostLimiters;
+    // Null unless HttpCircuitBreakerPolicy::enabled is set.
+    std::unique_ptr<CircuitBreakers> m_circuitBreakers;
+    // Null unless HttpClientConfig::responseCacheBytes is set.
+    std::unique_ptr<ResponseCache> m_cache;
+    // HttpClientConfig::resolve as a libcurl list, built once.
+    std::unique_ptr<curl_slist, SlistDeleter> m_resolve;
+    // The PEM files named in the config, read once and set on every handle as blobs. Empty when not configured.
+    std::string m_clientCert;
+    std::string m_clientKey;
+    std::string m_caCerts;
+    // Coalesced GETs in flight, keyed by flight_key.
+    mutable std::mutex m_flightsMutex;
+    mutable std::unordered_map<std::string, std::shared_future<std::expected<std::shared_ptr<const HttpResponse>, CurlError>>, TransparentStringHash, std::equal_to<>> m_flights;
+    // Declared before the pool so every pooled handle is cleaned up before the share is.
+    CurlShare m_share;
+    mutable CurlHandlePool m_handlePool;
+    // Started on first use and declared after the pool, so in-flight transfers
+    // are aborted and their handles returned before the pool is destroyed.
+    mutable std::once_flag m_engineOnce;
+    mutable std::unique_ptr<MultiEngine> m_engine;
+
+    [[nodiscard]] MultiEngine& engine() const;
+    void prepare(Transfer& transfer, const RequestSpec& spec) const;
+
+    // Helper functions to refactor performRequest
+    void configure_common_options(/* NOSONAR */ CURL* curl, const std::string& url, Transfer& transfer) const;
+    void configure_http_version(/* NOSONAR */ CURL* curl) const;
+    void configure_tls(/* NOSONAR */ CURL* curl) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> execute(const RequestSpec& spec, bool& outputStarted) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> execute_hedged(const RequestSpec& spec) const;
+    [[nodiscard]] std::optional<std::chrono::microseconds> hedge_delay() const;
+    // The blocking request paths return transport failures and policy rejections rather than throwing them,
+    // so that error-heavy callers of tryGet and tryPost never unwind; only setup failures throw.
+    [[nodiscard]] std::expected<HttpResponse, CurlError> perform_request(const RequestSpec& spec) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> perform_with_cache(const RequestSpec& spec) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> perform_attempts(const RequestSpec& spec) const;
+    [[nodiscard]] std::string flight_key(const RequestSpec& spec) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> perform_cached_get(const RequestSpec& spec) const;
+    [[nodiscard]] std::expected<HttpResponse, CurlError> revalidate(const RequestSpec& spec, const CacheEntry& entry) const;
+    [[nodiscard]] std::optional<std::string> request_header(const RequestSpec& spec, std::string_view name) const;
+    static void collect_response_info(Transfer& transfer);
+    static void read_timings(/* NOSONAR */ CURL* curl, HttpTimings& timings);
+    static void record_metrics(Transfer& transfer, CURLcode result);
+    [[nodiscard]] static CurlError transfer_error(const Transfer& transfer, CURLcode res, const char* prefix);
+    [[nodiscard]] static std::string failure_message(const Transfer& transfer, CURLcode res, const char* prefix);
+    void configure_post_body(/* NOSONAR */ CURL* curl, std::string_view postBody) const;
+    void configure_upload_stream(/* NOSONAR */ CURL* curl, Transfer& transfer, HttpUploadStream& stream) const;
+    void configure_expect_continue(/* NOSONAR */ CURL* curl, Transfer& transfer, const curl_slist* headerList, const RequestSpec& spec) const;
+    [[nodiscard]] std::string_view compress_post_body(/* NOSONAR */ CURL* curl, Transfer& transfer, std::string_view postBody, const curl_slist* headerList) const;
+    void configure_body_source(/* NOSONAR */ CURL* curl, Transfer& transfer, const HttpBodySource& source) const;
+    void build_multipart_form(/* NOSONAR */ CURL* curl, Transfer& transfer, const std::vector<HttpFormPart>& formParts) const;
+    
+    // Callbacks for libcurl
+    static size_t writeCallback(const char* ptr, size_t size, size_t nmemb, /* NOSONAR */ void* userdata);
+    static bool writeToDescriptor(int fd, const char* data, size_t length);
+    static size_t readCallback(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata);
+    static size_t uploadStreamRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata);
+    static size_t readFromSource(Transfer& transfer, const HttpBodySource& source, char* buffer, size_t capacity);
+    static size_t formBufferRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* arg);
+    static int formBufferSeek(/* NOSONAR */ void* arg, curl_off_t offset, int origin);
+    static size_t formStreamRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* arg);
+    static void reserveBody(Transfer& transfer);
+    static size_t headerCallback(const char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata);
+};
+
+// --- Callback Implementations ---
+
+size_t HttpClient::Impl::writeCallback(const char* ptr, size_t size, size_t nmemb, /* NOSONAR */ void* userdata) {
+    if (userdata == nullptr) return 0;
+    auto* transfer = static_cast<Transfer*>(userdata);
+    const size_t total_size = size * nmemb;
+    if (transfer->maxBodyBytes > 0 && total_size > transfer->maxBodyBytes - transfer->bodyBytes) {
+        transfer->bodyLimitExceeded = true;
+        return 0;
+    }
+    const bool first_chunk = transfer->bodyBytes == 0;
+    if (first_chunk && transfer->output.partialOnly) {
+        long status = 0;
+        curl_easy_getinfo(transfer->handle.get(), CURLINFO_RESPONSE_CODE, &status);
+        if (status != 206L) {
+            transfer->rangeIgnored = true;
+            return 0;
+        }
+    }
+    transfer->bodyBytes += total_size;
+    try {
+        if (transfer->output.sink) {
+            if (!(*transfer->output.sink)(std::span<const char>(ptr, total_size))) {
+                transfer->outputAborted = true;
+                return 0;
+            }
+        } else if (transfer->output.fd) {
+            if (!writeToDescriptor(*transfer->output.fd, ptr, total_size)) {
+                transfer->outputAborted = true;
+                return 0;
+            }
+        } else {
+            if (first_chunk) {
+                reserveBody(*transfer);
+            }
+            transfer->response.body.append(ptr, total_size);
+        }
+    } catch (const std::bad_alloc&) {
+        return 0; 
+    } catch (...) { // NOSONAR: exceptions must not cross libcurl's C frames; rethrown after the transfer
+        transfer->callbackError = std::current_exception();
+        return 0;
+    }
+    return total_size;
+}
+
+// Pulls the next piece of the request body from the caller's HttpBodySource.
+size_t HttpClient::Impl::readCallback(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata) {
+    if (userdata == nullptr) return CURL_READFUNC_ABORT;
+    auto* transfer = static_cast<Transfer*>(userdata);
+    return readFromSource(*transfer, *transfer->source, buffer, size * nitems);
+}
+
+// Drains the upload stream, or pauses the transfer until the producer writes more.
+size_t HttpClient::Impl::uploadStreamRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata) {
+    if (userdata == nullptr) return CURL_READFUNC_ABORT;
+    auto& state = *static_cast<HttpUploadStream::State*>(userdata);
+    std::scoped_lock lock(state.mutex);
+    if (state.aborted) {
+        return CURL_READFUNC_ABORT;
+    }
+    const std::size_t length = std::min(size * nitems, state.queued());
+    if (length == 0) {
+        if (state.closed) return 0;
+        state.paused = true;
+        return CURL_READFUNC_PAUSE;
+    }
+    std::memcpy(buffer, state.buffer.data() + state.readOffset, length);
+    state.readOffset += length;
+    if (state.readOffset == state.buffer.size()) {
+        state.buffer.clear();
+        state.readOffset = 0;
+    }
+    state.space.notify_all();
+    return length;
+}
+
+size_t HttpClient::Impl::readFromSource(Transfer& transfer, const HttpBodySource& source, char* buffer, size_t capacity) {
+    try {
+        const size_t produced = source.read(std::span<char>(buffer, capacity));
+        if (produced > capacity) {
+            transfer.sourceFailed = true;
+            return CURL_READFUNC_ABORT;
+        }
+        return produced;
+    } catch (...) { // NOSONAR: exceptions must not cross libcurl's C frames; rethrown after the transfer
+        transfer.callbackError = std::current_exception();
+        return CURL_READFUNC_ABORT;
+    }
+}
+
+size_t HttpClient::Impl::formBufferRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* arg) {
+    auto* reader = static_cast<FormPartReader*>(arg);
+    const size_t length = std::min(size * nitems, reader->buffer.size() - reader->offset);
+    std::memcpy(buffer, reader->buffer.data() + reader->offset, length);
+    reader->offset += length;
+    return length;
+}
+
+// Lets libcurl rewind a buffered part, e.g. when a redirect or authentication resends the form.
+int HttpClient::Impl::formBufferSeek(/* NOSONAR */ void* arg, curl_off_t offset, int origin) {
+    auto* reader = static_cast<FormPartReader*>(arg);
+    const auto size = static_cast<curl_off_t>(reader->buffer.size());
+    curl_off_t base = 0;
+    if (origin == SEEK_CUR) {
+        base = static_cast<curl_off_t>(reader->offset);
+    } else if (origin == SEEK_END) {
+        base = size;
+    }
+    if (offset < -base || offset > size - base) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+    reader->offset = static_cast<std::size_t>(base + offset);
+    return CURL_SEEKFUNC_OK;
+}
+
+size_t HttpClient::Impl::formStreamRead(char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* arg) {
+    auto* reader = static_cast<FormPartReader*>(arg);
+    return readFromSource(*reader->transfer, reader->generator, buffer, size * nitems);
+}
+
+// Sizes the body buffer once from the announced Content-Length, instead of letting it grow chunk by chunk.
+// The reservation is capped so a hostile or bogus length cannot force a huge allocation up front.
+void HttpClient::Impl::reserveBody(Transfer& transfer) {
+    static constexpr curl_off_t MAX_UNBOUNDED_RESERVE = 64L * 1024 * 1024;
+
+    curl_off_t content_length = -1;
+    if (curl_easy_getinfo(transfer.handle.get(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length) != CURLE_OK || content_length <= 0) {
+        return;
+    }
+    const curl_off_t limit = transfer.maxBodyBytes > 0 ? static_cast<curl_off_t>(transfer.maxBodyBytes) : MAX_UNBOUNDED_RESERVE;
+    transfer.response.body.reserve(static_cast<size_t>(std::min(content_length, limit)));
+}
+
+bool HttpClient::Impl::writeToDescriptor(int fd, const char* data, size_t length) {
+    while (length > 0) {
+#ifdef _WIN32
+        const auto written = _write(fd, data, static_cast<unsigned int>(length));
+#else
+        const auto written = write(fd, data, length);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+size_t HttpClient::Impl::headerCallback(const char* buffer, size_t size, size_t nitems, /* NOSONAR */ void* userdata) {
+    if (userdata == nullptr) return 0;
+    auto* responseHeaders = static_cast<HttpHeaders*>(userdata);
+    try {
+        responseHeaders->append(std::string_view(buffer, size * nitems));
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+    return size * nitems;
+}
+
+// --- Refactored Helper Functions ---
+
+void HttpClient::Impl::configure_common_options(/* NOSONAR */ CURL* curl, const std::string& url, Transfer& transfer) const {
+    static constexpr const char* USER_AGENT = "cpp-http-client/1.0";
+    static constexpr long FOLLOW_REDIRECTS = 1L;
+
+    m_share.attach(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, m_config.connectTimeoutMs);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, m_config.requestTimeoutMs);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, FOLLOW_REDIRECTS);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, USER_AGENT);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer.response.headers);
+    if (m_config.acceptEncoding) {
+        // libcurl sends the header and decodes the matching Content-Encoding before the body reaches writeCallback.
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, m_config.acceptEncoding->c_str());
+    }
+
+    if (!m_config.unixSockets.empty()) {
+        if (const auto socket = m_config.unixSockets.find(url_origin(url)); socket != m_config.unixSockets.end()) {
+            curl_easy_setopt(curl, socket->second.abstract ? CURLOPT_ABSTRACT_UNIX_SOCKET : CURLOPT_UNIX_SOCKET_PATH,
+                             socket->second.path.c_str());
+        }
+    }
+    if (m_resolve) curl_easy_setopt(curl, CURLOPT_RESOLVE, m_resolve.get());
+    curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, m_config.dnsCacheTtlSeconds);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, m_config.tcpNoDelay ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_HAPPY_EYEBALLS_TIMEOUT_MS, m_config.happyEyeballsTimeoutMs);
+    if (m_config.tcpKeepAlive) {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, m_config.tcpKeepIdleSeconds);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, m_config.tcpKeepIntervalSeconds);
+    }
+    
+    configure_http_version(curl);
+    configure_tls(curl);
+
+    transfer.maxBodyBytes = m_config.maxBodyBytes;
+    if (m_config.maxBodyBytes > 0) {
+        // Lets libcurl reject a response up front when its Content-Length is already over the limit.
+        curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, static_cast<curl_off_t>(m_config.maxBodyBytes));
+    }
+}
+
+void HttpClient::Impl::configure_tls(/* NOSONAR */ CURL* curl) const {
+    long version = tls_version_option(m_config.tlsMinVersion);
+    if (m_config.tlsMaxVersion) version |= tls_max_version_option(*m_config.tlsMaxVersion);
+    curl_easy_setopt(curl, CURLOPT_SSLVERSION, version);
+    if (m_config.tlsCipherList) curl_easy_setopt(curl, CURLOPT_SSL_CIPHER_LIST, m_config.tlsCipherList->c_str());
+    if (m_config.tls13CipherSuites) curl_easy_setopt(curl, CURLOPT_TLS13_CIPHERS, m_config.tls13CipherSuites->c_str());
+    if (!m_config.tlsAlpn) curl_easy_setopt(curl, CURLOPT_SSL_ENABLE_ALPN, 0L);
+
+    // libcurl copies the blob descriptor but, with CURL_BLOB_NOCOPY, not the PEM data itself.
+    set_tls_blob(curl, CURLOPT_SSLCERT_BLOB, m_clientCert);
+    set_tls_blob(curl, CURLOPT_SSLKEY_BLOB, m_clientKey);
+    set_tls_blob(curl, CURLOPT_CAINFO_BLOB, m_caCerts);
+    if (m_config.clientKeyPassword) curl_easy_setopt(curl, CURLOPT_KEYPASSWD, m_config.clientKeyPassword->c_str());
+}
+
+void HttpClient::Impl::configure_http_version(/* NOSONAR */ CURL* curl) const {
+    long version = CURL_HTTP_VERSION_NONE;
+    switch (m_config.httpVersion) {
+        using enum HttpVersion;
+        case Default: return;
+        case Http1_1: version = CURL_HTTP_VERSION_1_1; break;
+        case Http2Tls: version = CURL_HTTP_VERSION_2TLS; break;
+        case Http2PriorKnowledge: version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE; break;
+        case Http3: version = CURL_HTTP_VERSION_3; break;
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, version);
+    // Versions negotiated through ALPN only learn that a connection can multiplex after the handshake,
+    // so concurrent transfers wait for it instead of each opening their own connection. Prior-knowledge
+    // connections multiplex from the start and must not wait (older libcurl breaks the stream if they do).
+    const bool negotiated = m_config.httpVersion == HttpVersion::Http2Tls || m_config.httpVersion == HttpVersion::Http3;
+    if (m_config.multiplex && negotiated) {
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+}
+
+[[nodiscard]] curl_slist* HttpClient::Impl::build_headers(const std::map<std::string, std::string, std::less<>>& headers) const {
+    std::unique_ptr<curl_slist, SlistDeleter> header_list;
+    for (const auto& [key, value] : m_config.defaultHeaders) {
+        const bool overridden = std::ranges::any_of(headers, [&key](const auto& header) { return header_name_equal(header.first, key); });
+        if (!overridden) {
+            header_list.reset(append_header(header_list.release(), key, value));
+        }
+    }
+    for (const auto& [key, value] : headers) {
+        header_list.reset(append_header(header_list.release(), key, value));
+    }
+    return header_list.release();
+}
+
+// The body is sent from the caller's memory; CURLOPT_POSTFIELDS does not copy it, and its length is
+// given explicitly so the data does not need to be null-terminated.
+void HttpClient::Impl::configure_post_body(/* NOSONAR */ CURL* curl, std::string_view postBody) const {
+    if (postBody.size() > static_cast<size_t>(std::numeric_limits<curl_off_t>::max())) {
+        throw CurlException("POST body is too large to be handled by libcurl.");
+    }
+    // A null pointer would make libcurl read the body from stdin, so an empty view still needs valid storage.
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postBody.data() ? postBody.data() : "");
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(postBody.size()));
+}
+
+// Replaces a large body with its gzip form when compressRequestsAbove applies, and adds the matching header
+// to a transfer-owned copy of the header list. Returns the body to send.
+[[nodiscard]] std::string_view HttpClient::Impl::compress_post_body(/* NOSONAR */ CURL* curl, Transfer& transfer, std::string_view postBody,
+                                                                    const curl_slist* headerList) const {
+#ifdef HTTPCLIENT_WITH_ZLIB
+    if (m_config.compressRequestsAbove == 0 || postBody.size() < m_config.compressRequestsAbove || has_header(headerList, "Content-Encoding")) {
+        return postBody;
+    }
+    auto compressed = gzip_compress(postBody);
+    if (!compressed) {
+        return postBody;
+    }
+    if (headerList != transfer.headerList.get()) {
+        transfer.headerList.reset(copy_headers(headerList));
+    }
+    transfer.headerList.reset(append_header(transfer.headerList.release(), "Content-Encoding", "gzip"));
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.headerList.get());
+    transfer.compressedBody = std::move(*compressed);
+    return transfer.compressedBody;
+#else
+    (void)curl;
+    (void)transfer;
+    (void)headerList;
+    return postBody;
+#endif
+}
+
+void HttpClient::Impl::configure_body_source(/* NOSONAR */ CURL* curl, Transfer& transfer, const HttpBodySource& source) const {
+    if (!source.read) {
+        throw CurlException("HttpBodySource has no read function.");
+    }
+    if (source.contentLength && *source.contentLength > static_cast<std::uint64_t>(std::numeric_limits<curl_off_t>::max())) {
+        throw CurlException("POST body is too large to be handled by libcurl.");
+    }
+    transfer.source = &source;
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, readCallback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, &transfer);
+    // A size of -1 makes libcurl use chunked transfer encoding.
+    const auto length = source.contentLength ? static_cast<curl_off_t>(*source.contentLength) : curl_off_t{-1};
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, length);
+}
+
+// Only asynchronous requests take an upload stream, because a paused transfer can only be resumed
+// from the thread driving it: the stream wakes the event loop to do that.
+void HttpClient::Impl::configure_upload_stream(/* NOSONAR */ CURL* curl, Transfer& transfer, HttpUploadStream& stream) const {
+    HttpUploadStream::State& state = *stream.m_state;
+    {
+        std::scoped_lock lock(state.mutex);
+        if (state.attached) {
+            throw CurlException("An HttpUploadStream can only carry one request.");
+        }
+        state.attached = true;
+        state.engine = &engine();
+        state.curl = curl;
+    }
+    transfer.upload = stream.m_state;
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadStreamRead);
+    curl_easy_setopt(curl, CURLOPT_READDATA, &state);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, curl_off_t{-1});
+}
+
+// libcurl sends "Expect: 100-continue" with HTTP/1.1 bodies over 1 MiB and with bodies of unknown
+// size, then waits for the server before sending them. Unless expectContinue is set, the header is
+// removed with an empty "Expect:" entry. Smaller bodies of known size never get the header, so their
+// (possibly shared) header lists are left alone.
+void HttpClient::Impl::configure_expect_continue(/* NOSONAR */ CURL* curl, Transfer& transfer, const curl_slist* headerList,
+                                                 const RequestSpec& spec) const {
+    static constexpr std::uint64_t EXPECT_THRESHOLD = 1024 * 1024;
+    if (m_config.expectContinue) {
+        curl_easy_setopt(curl, CURLOPT_EXPECT_100_TIMEOUT_MS, m_config.expectContinueTimeoutMs);
+        return;
+    }
+    const bool known_small = (spec.body && spec.body->size() < EXPECT_THRESHOLD) ||
+                             (spec.source && spec.source->contentLength && *spec.source->contentLength < EXPECT_THRESHOLD);
+    if (known_small) {
+        return;
+    }
+    // compress_post_body may have replaced the list already.
+    const curl_slist* current = transfer.headerList ? transfer.headerList.get() : headerList;
+    if (has_header(current, "Expect")) {
+        return;
+    }
+    if (current != transfer.headerList.get()) {
+        transfer.headerList.reset(copy_headers(current));
+    }
+    curl_slist* appended = curl_slist_append(transfer.headerList.get(), "Expect:");
+    if (!appended) {
+        throw CurlException("curl_slist_append() failed.");
+    }
+    static_cast<void>(transfer.headerList.release());
+    transfer.headerList.reset(appended);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.headerList.get());
+}
+
+void HttpClient::Impl::build_multipart_form(/* NOSONAR */ CURL* curl, Transfer& transfer, const std::vector<HttpFormPart>& formParts) const {
+    transfer.mime.reset(curl_mime_init(curl));
+    if (!transfer.mime) {
+        throw CurlException("curl_mime_init() failed.");
+    }
+    curl_mime* mime = transfer.mime.get();
+
+    const auto streamed_parts = std::ranges::count_if(formParts, [](const HttpFormPart& part) {
+        return std::holds_alternative<HttpFormBuffer>(part.contents) || std::holds_alternative<HttpFormStream>(part.contents);
+    });
+    transfer.formReaders.reserve(static_cast<std::size_t>(streamed_parts));
+
+    for (const auto& part : formParts) {
+        curl_mimepart* mime_part = curl_mime_addpart(mime);
+        curl_mime_name(mime_part, part.name.c_str());
+
+        const std::optional<std::string>* file_name = nullptr;
+        const std::optional<std::string>* content_type = nullptr;
+        if (const auto* value = std::get_if<std::string>(&part.contents)) {
+            curl_mime_data(mime_part, value->c_str(), value->length());
+        } else if (const auto* file = std::get_if<HttpFormFile>(&part.contents)) {
+            curl_mime_filedata(mime_part, file->filePath.c_str());
+            content_type = &file->contentType;
+        } else if (const auto* buffer = std::get_if<HttpFormBuffer>(&part.contents)) {
+            auto& reader = transfer.formReaders.emplace_back(FormPartReader{.transfer = &transfer, .buffer = buffer->data, .offset = 0, .generator = {}});
+            curl_mime_data_cb(mime_part, static_cast<curl_off_t>(buffer->data.size()), formBufferRead, formBufferSeek, nullptr, &reader);
+            file_name = &buffer->fileName;
+            content_type = &buffer->contentType;
+        } else {
+            const auto& stream = std::get<HttpFormStream>(part.contents);
+            if (!stream.source.read) {
+                throw CurlException("HttpFormStream for part '" + part.name + "' has no read function.");
+            }
+            auto& reader = transfer.formReaders.emplace_back(FormPartReader{.transfer = &transfer, .buffer = {}, .offset = 0, .generator = stream.source});
+            // A size of -1 leaves the part length open, which makes libcurl send the request chunked.
+            const auto size = stream.source.contentLength ? static_cast<curl_off_t>(*stream.source.contentLength) : curl_off_t{-1};
+            curl_mime_data_cb(mime_part, size, formStreamRead, nullptr, nullptr, &reader);
+            file_name = &stream.fileName;
+            content_type = &stream.contentType;
+        }
+        if (file_name && *file_name) {
+            curl_mime_filename(mime_part, (*file_name)->c_str());
+        }
+        if (content_type && *content_type) {
+            curl_mime_type(mime_part, (*content_type)->c_str());
+        }
+    }
+}
+
+
+// --- Main Request Functions ---
+
+void HttpClient::Impl::prepare(Transfer& transfer, const RequestSpec& spec) const {
+    CURL* curl = transfer.handle.get();
+    transfer.output = spec.output;
+
+    // Step 1: Configure all common options
+    configure_common_options(curl, spec.url, transfer);
+    if (spec.head) {
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    }
+#ifdef CURLSSLOPT_EARLYDATA
+    // Early data can be replayed, so only requests without a body are sent as 0-RTT.
+    if (m_config.tlsEarlyData && !spec.body && !spec.source && !spec.formParts && !spec.upload) {
+        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, static_cast<long>(CURLSSLOPT_EARLYDATA));
+    }
+#endif
+
+    // Step 2: Set headers. Prepared lists and the client defaults are used as-is without rebuilding.
+    const curl_slist* header_list = nullptr;
+    if (spec.preparedHeaders) {
+        header_list = spec.preparedHeaders->m_list;
+    } else if (spec.headers.empty()) {
+        header_list = m_defaultHeaders.m_list;
+    } else {
+        transfer.headerList.reset(build_headers(spec.headers));
+        header_list = transfer.headerList.get();
+    }
+    if (header_list) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+    }
+
+    // Step 3: Configure POST data (if any)
+    if (spec.formParts) {
+        build_multipart_form(curl, transfer, *spec.formParts);
+        curl_easy_setopt(curl, CURLOPT_MIMEPOST, transfer.mime.get());
+    } else if (spec.source) {
+        configure_body_source(curl, transfer, *spec.source);
+    } else if (spec.upload) {
+        configure_upload_stream(curl, transfer, *spec.upload);
+    } else if (spec.body) {
+        configure_post_body(curl, compress_post_body(curl, transfer, *spec.body, header_list));
+    }
+    if (spec.body || spec.source || spec.formParts || spec.upload) {
+        configure_expect_continue(curl, transfer, header_list, spec);
+    }
+
+    if (m_metrics) {
+        transfer.metrics = m_metrics.get();
+        transfer.metricsPending = true;
+        m_metrics->requestStarted();
+    }
+}
+
+// Reads the status code, timing breakdown and connection details of a finished transfer.
+void HttpClient::Impl::collect_response_info(Transfer& transfer) {
+    CURL* curl = transfer.handle.get();
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &transfer.response.statusCode);
+    read_timings(curl, transfer.response.timings);
+}
+
+// Reads the timing breakdown and connection details of a transfer, which also tell how far a failed one got.
+void HttpClient::Impl::read_timings(/* NOSONAR */ CURL* curl, HttpTimings& timings) {
+    const auto read_time = [curl](CURLINFO info) {
+        curl_off_t value = 0;
+        curl_easy_getinfo(curl, info, &value);
+        return std::chrono::microseconds(value);
+    };
+    timings.nameLookup = read_time(CURLINFO_NAMELOOKUP_TIME_T);
+    timings.connect = read_time(CURLINFO_CONNECT_TIME_T);
+    timings.appConnect = read_time(CURLINFO_APPCONNECT_TIME_T);
+    timings.preTransfer = read_time(CURLINFO_PRETRANSFER_TIME_T);
+    timings.startTransfer = read_time(CURLINFO_STARTTRANSFER_TIME_T);
+    timings.total = read_time(CURLINFO_TOTAL_TIME_T);
+    timings.redirect = read_time(CURLINFO_REDIRECT_TIME_T);
+
+    curl_off_t uploaded = 0;
+    curl_off_t downloaded = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    timings.bytesUploaded = static_cast<std::uint64_t>(std::max<curl_off_t>(uploaded, 0));
+    timings.bytesDownloaded = static_cast<std::uint64_t>(std::max<curl_off_t>(downloaded, 0));
+
+    // libcurl counts the connections it had to open for this transfer; none means an existing one was reused.
+    long new_connections = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+    timings.connectionReused = new_connections == 0;
+
+    long version = CURL_HTTP_VERSION_NONE;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+    switch (version) {
+        case CURL_HTTP_VERSION_1_0: timings.httpVersion = 10; break;
+        case CURL_HTTP_VERSION_1_1: timings.httpVersion = 11; break;
+        case CURL_HTTP_VERSION_2_0: timings.httpVersion = 20; break;
+        case CURL_HTTP_VERSION_3: timings.httpVersion = 30; break;
+        default: timings.httpVersion = 0; break;
+    }
+}
+
+void HttpClient::Impl::record_metrics(Transfer& transfer, CURLcode result) {
+    if (!transfer.metricsPending) return;
+    transfer.metricsPending = false;
+
+    CURL* curl = transfer.handle.get();
+    const char* effective_url = nullptr;
+    long status_code = 0;
+    curl_off_t total_time = 0;
+    long new_connections = 0;
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total_time);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+    transfer.metrics->requestFinished(url_host(effective_url ? effective_url : ""), status_code, result,
+                                      std::chrono::microseconds(total_time), new_connections == 0);
+}
+
+// Describes a failed transfer, including the timings of how far it got.
+[[nodiscard]] CurlError HttpClient::Impl::transfer_error(const Transfer& transfer, CURLcode res, const char* prefix) {
+    CurlError error{res, failure_message(transfer, res, prefix), error_phase(res)};
+    read_timings(transfer.handle.get(), error.timings);
+    return error;
+}
+
+[[nodiscard]] std::string HttpClient::Impl::failure_message(const Transfer& transfer, CURLcode res, const char* prefix) {
+    if (transfer.bodyLimitExceeded || res == CURLE_FILESIZE_EXCEEDED) {
+        return "Response body exceeds the configured maxBodyBytes limit.";
+    }
+    if (transfer.sourceFailed) {
+        return "HttpBodySource::read returned more bytes than the buffer holds.";
+    }
+    if (transfer.outputAborted) {
+        return transfer.output.sink ? "Transfer aborted by the response body sink."
+                                    : "Failed to write the response body to the file descriptor.";
+    }
+    return std::string(prefix) + curl_easy_strerror(res);
+}
+
+// Runs a single attempt of a blocking request. Exceptions thrown by a body sink or source propagate.
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::execute(const RequestSpec& spec, bool& outputStarted) const {
+    Transfer transfer(m_handlePool);
+    if (spec.reuse) {
+        spec.reuse->statusCode = 0;
+        spec.reuse->body.clear();
+        spec.reuse->headers.clear();
+        spec.reuse->timings = {};
+        transfer.response = std::move(*spec.reuse);
+    }
+    prepare(transfer, spec);
+    CURL* curl = transfer.handle.get();
+
+    // Step 4: Perform the request
+    CURLcode res = curl_easy_perform(curl);
+    if (res == CURLE_WRITE_ERROR && transfer.rangeIgnored) res = CURLE_OK;
+    record_metrics(transfer, res);
+    outputStarted = transfer.bodyBytes > 0 && (transfer.output.sink || transfer.output.fd);
+    if (res != CURLE_OK) {
+        if (spec.reuse) {
+            *spec.reuse = std::move(transfer.response);
+        }
+        if (transfer.callbackError) {
+            std::rethrow_exception(transfer.callbackError);
+        }
+        return std::unexpected(transfer_error(transfer, res, "curl_easy_perform() failed: "));
+    }
+
+    // Step 5: Retrieve the status code and timings
+    collect_response_info(transfer);
+    
+    return std::move(transfer.response);
+}
+
+[[nodiscard]] std::optional<std::chrono::microseconds> HttpClient::Impl::hedge_delay() const {
+    const HttpHedgingPolicy& policy = m_config.hedging;
+    if (policy.delay) {
+        return *policy.delay;
+    }
+    const auto observed = m_getLatencies.percentile(policy.percentile);
+    if (!observed) {
+        return std::nullopt;
+    }
+    return std::max<std::chrono::microseconds>(*observed, policy.minDelay);
+}
+
+// Runs a buffered GET on the event loop and sends up to maxHedges copies of it, each after another
+// hedge delay, until one of them produces a response. The others are cancelled, and the call only
+// returns once every copy has finished, as they all reference the caller's spec. The first copy runs
+// in the caller's host slot; each hedge needs a free slot of its own and is skipped if there is none.
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::execute_hedged(const RequestSpec& spec) const {
+    const auto delay = hedge_delay();
+    if (!delay) {
+        bool output_started = false;
+        return execute(spec, output_started);
+    }
+
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable changed;
+        // The first response, or the latest failure while no copy has succeeded.
+        std::optional<std::expected<HttpResponse, CurlError>> result;
+        int running = 0;
+    } race;
+    std::vector<std::uint64_t> tickets;
+
+    // The slot is released as soon as its copy finishes, with a sample unless the copy was cancelled.
+    const auto launch = [this, &spec, &race, &tickets](std::shared_ptr<HostSlot> slot) {
+        {
+            std::scoped_lock lock(race.mutex);
+            ++race.running;
+        }
+        const auto started = std::chrono::steady_clock::now();
+        tickets.push_back(performRequestAsync(spec, std::nullopt, [&race, slot = std::move(slot), started](std::expected<HttpResponse, CurlError> result) mutable {
+            if (slot && (result || result.error().code != CURLE_ABORTED_BY_CALLBACK)) {
+                slot->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started),
+                             looks_overloaded(result));
+            }
+            slot.reset();
+            // Notified under the lock, since the waiting thread destroys the race as soon as it sees it finished.
+            std::scoped_lock lock(race.mutex);
+            --race.running;
+            if (!race.result || (!race.result->has_value() && result.has_value())) {
+                race.result = std::move(result);
+            }
+            race.changed.notify_all();
+        }));
+    };
+    const auto decided = [&race] { return (race.result && race.result->has_value()) || race.running == 0; };
+    HostLimiter* limiter = m_hostLimiters ? &m_hostLimiters->forHost(url_host(spec.url)) : nullptr;
+
+    launch(nullptr);
+    std::unique_lock lock(race.mutex);
+    for (int hedges = 0; hedges < m_config.hedging.maxHedges; ++hedges) {
+        if (race.changed.wait_for(lock, *delay, decided)) break;
+        std::shared_ptr<HostSlot> slot;
+        if (limiter) {
+            slot = std::make_shared<HostSlot>(*limiter, std::try_to_lock);
+            if (!slot->acquired()) continue;
+        }
+        if (!m_retryBudget.withdraw()) break;
+        lock.unlock();
+        launch(std::move(slot));
+        lock.lock();
+    }
+    race.changed.wait(lock, decided);
+    if (race.running > 0) {
+        lock.unlock();
+        for (const std::uint64_t ticket : tickets) {
+            if (ticket != 0) engine().cancel(ticket);
+        }
+        lock.lock();
+        race.changed.wait(lock, [&race] { return race.running == 0; });
+    }
+    return std::move(*race.result);
+}
+
+[[nodiscard]] HttpResponse HttpClient::Impl::performRequest(const RequestSpec& spec) const {
+    auto result = perform_request(spec);
+    if (!result) {
+        throw_error(result.error());
+    }
+    return std::move(*result);
+}
+
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::tryPerformRequest(const RequestSpec& spec) const {
+    try {
+        return perform_request(spec);
+    } catch (const CurlException& e) {
+        return std::unexpected(CurlError{CURLE_FAILED_INIT, e.what(), HttpErrorPhase::Setup});
+    }
+}
+
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::perform_request(const RequestSpec& spec) const {
+    const bool buffered_get = !spec.body && !spec.source && !spec.formParts && !spec.output.sink && !spec.output.fd && !spec.head;
+    if (m_config.coalesceGets && buffered_get) {
+        auto shared = performShared(spec);
+        if (!shared) return std::unexpected(std::move(shared.error()));
+        return **shared;
+    }
+    return perform_with_cache(spec);
+}
+
+// Identifies a GET by its URL and the exact header lines it sends.
+[[nodiscard]] std::string HttpClient::Impl::flight_key(const RequestSpec& spec) const {
+    std::string key = spec.url;
+    const auto append_line = [&key](std::string_view name, std::string_view value) {
+        key.append("\n").append(name).append(": ").append(value);
+    };
+    if (spec.preparedHeaders) {
+        for (const curl_slist* item = spec.preparedHeaders->m_list; item; item = item->next) {
+            key.append("\n").append(item->data);
+        }
+        return key;
+    }
+    for (const auto& [name, value] : m_config.defaultHeaders) {
+        const bool overridden = std::ranges::any_of(spec.headers, [&name](const auto& header) { return header_name_equal(header.first, name); });
+        if (!overridden) append_line(name, value);
+    }
+    for (const auto& [name, value] : spec.headers) {
+        append_line(name, value);
+    }
+    return key;
+}
+
+[[nodiscard]] std::expected<std::shared_ptr<const HttpResponse>, CurlError> HttpClient::Impl::performShared(const RequestSpec& spec) const {
+    std::string key = flight_key(spec);
+    std::promise<std::expected<std::shared_ptr<const HttpResponse>, CurlError>> promise;
+    {
+        std::unique_lock lock(m_flightsMutex);
+        const auto [flight, leader] = m_flights.try_emplace(key);
+        if (!leader) {
+            const auto result = flight->second;
+            lock.unlock();
+            return result.get();
+        }
+        flight->second = promise.get_future().share();
+    }
+
+    // The flight is removed before its result is published, so later callers start a fresh transfer.
+    const auto land = [this, &key] {
+        std::scoped_lock lock(m_flightsMutex);
+        m_flights.erase(key);
+    };
+    try {
+        auto response = perform_with_cache(spec);
+        std::expected<std::shared_ptr<const HttpResponse>, CurlError> result;
+        if (response) {
+            result = std::make_shared<const HttpResponse>(std::move(*response));
+        } else {
+            result = std::unexpected(std::move(response.error()));
+        }
+        land();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        land();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::perform_with_cache(const RequestSpec& spec) const {
+    if (!m_cache) {
+        return perform_attempts(spec);
+    }
+    if (spec.body || spec.source || spec.formParts) {
+        // A successful unsafe request may have changed the resource, so its cached GET responses are dropped.
+        auto response = perform_attempts(spec);
+        if (response && response->statusCode < 400L) {
+            m_cache->invalidate(spec.url);
+        }
+        return response;
+    }
+    if (spec.output.sink || spec.output.fd || spec.head) {
+        return perform_attempts(spec);
+    }
+    return perform_cached_get(spec);
+}
+
+// The value a request sends for a header: from its prepared list, or from the per-call headers
+// overlaid on the client defaults.
+[[nodiscard]] std::optional<std::string> HttpClient::Impl::request_header(const RequestSpec& spec, std::string_view name) const {
+    if (spec.preparedHeaders) {
+        const auto value = find_header(spec.preparedHeaders->m_list, name);
+        return value ? std::optional<std::string>(*value) : std::nullopt;
+    }
+    const auto matches = [name](const auto& header) { return header_name_equal(header.first, name); };
+    if (const auto it = std::ranges::find_if(spec.headers, matches); it != spec.headers.end()) {
+        return it->second;
+    }
+    if (const auto it = std::ranges::find_if(m_config.defaultHeaders, matches); it != m_config.defaultHeaders.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::perform_cached_get(const RequestSpec& spec) const {
+    // Callers sending their own validators expect to see the 304 themselves.
+    if (request_header(spec, "If-None-Match") || request_header(spec, "If-Modified-Since")) {
+        return perform_attempts(spec);
+    }
+    const auto request_cache_control = request_header(spec, "Cache-Control");
+    const CacheDirectives request_directives = request_cache_control ? parse_cache_control(*request_cache_control) : CacheDirectives{};
+    if (request_directives.noStore) {
+        return perform_attempts(spec);
+    }
+
+    const auto header_of_request = [this, &spec](std::string_view name) { return request_header(spec, name); };
+    const auto hit = m_cache->find(spec.url, header_of_request);
+    const auto served_from_cache = [](const CacheEntry& entry) {
+        HttpResponse response = entry.response;
+        response.timings = {};
+        return response;
+    };
+    if (hit && hit->fresh && !request_directives.noCache) {
+        return served_from_cache(*hit->entry);
+    }
+
+    const HttpHeaders* stored_headers = hit ? &hit->entry->response.headers : nullptr;
+    const bool revalidating = stored_headers && (stored_headers->contains("ETag") || stored_headers->contains("Last-Modified"));
+    auto response = revalidating ? revalidate(spec, *hit->entry) : perform_attempts(spec);
+    if (!response) {
+        return response;
+    }
+    if (revalidating && response->statusCode == 304L) {
+        // Freshness comes from the 304 when it carries its own Cache-Control, and from the stored response otherwise.
+        const HttpHeaders& source = response->headers.contains("Cache-Control") ? response->headers : *stored_headers;
+        m_cache->renew(hit->entry, response_freshness(source, std::chrono::steady_clock::now()));
+        return served_from_cache(*hit->entry);
+    }
+    if (response->statusCode != 200L) {
+        return response;
+    }
+
+    const auto cache_control = response->headers.get("Cache-Control");
+    const CacheDirectives directives = cache_control ? parse_cache_control(*cache_control) : CacheDirectives{};
+    const CacheFreshness freshness = response_freshness(response->headers, std::chrono::steady_clock::now());
+    const bool has_validators = response->headers.contains("ETag") || response->headers.contains("Last-Modified");
+    const bool fresh = !freshness.noCache && freshness.expires > std::chrono::steady_clock::now();
+    if (directives.noStore || (!fresh && !has_validators)) {
+        return response;
+    }
+
+    auto entry = std::make_shared<CacheEntry>();
+    std::string_view vary = response->headers.get("Vary").value_or(std::string_view{});
+    while (!vary.empty()) {
+        const size_t comma = vary.find(',');
+        const std::string_view name = trim(vary.substr(0, comma), HEADER_WHITESPACE, HEADER_WHITESPACE);
+        vary = comma == std::string_view::npos ? std::string_view{} : vary.substr(comma + 1);
+        if (name == "*") {
+            return response;
+        }
+        if (!name.empty()) {
+            entry->vary.emplace_back(std::string(name), request_header(spec, name));
+        }
+    }
+    entry->url = spec.url;
+    entry->response = *response;
+    entry->bytes = CACHE_ENTRY_OVERHEAD + entry->url.size() + response->body.size();
+    for (const auto& [name, value] : response->headers) {
+        entry->bytes += name.size() + value.size();
+    }
+    for (const auto& [name, value] : entry->vary) {
+        entry->bytes += name.size() + value.value_or(std::string{}).size();
+    }
+    m_cache->store(std::move(entry), freshness);
+    return response;
+}
+
+// Repeats a GET with the stored response's validators, so an unchanged resource comes back as 304.
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::revalidate(const RequestSpec& spec, const CacheEntry& entry) const {
+    std::vector<std::pair<std::string, std::string>> conditions;
+    if (const auto etag = entry.response.headers.get("ETag")) {
+        conditions.emplace_back("If-None-Match", std::string(*etag));
+    }
+    if (const auto last_modified = entry.response.headers.get("Last-Modified")) {
+        conditions.emplace_back("If-Modified-Since", std::string(*last_modified));
+    }
+
+    if (spec.preparedHeaders) {
+        std::unique_ptr<curl_slist, SlistDeleter> list(copy_headers(spec.preparedHeaders->m_list));
+        for (const auto& [name, value] : conditions) {
+            list.reset(append_header(list.release(), name, value));
+        }
+        const PreparedHeaders conditional(list.release());
+        return perform_attempts({.url = spec.url, .headers = spec.headers, .preparedHeaders = &conditional});
+    }
+    auto headers = spec.headers;
+    for (auto& [name, value] : conditions) {
+        headers.insert_or_assign(std::move(name), std::move(value));
+    }
+    return perform_attempts({.url = spec.url, .headers = headers});
+}
+
+[[nodiscard]] std::expected<HttpResponse, CurlError> HttpClient::Impl::perform_attempts(const RequestSpec& spec) const {
+    const HttpRetryPolicy& policy = m_config.retry;
+    const bool idempotent = !spec.body && !spec.source && !spec.formParts;
+    const bool replayable = !spec.source &&
+        !(spec.formParts && std::ranges::any_of(*spec.formParts, [](const HttpFormPart& part) {
+            return std::holds_alternative<HttpFormStream>(part.contents);
+        }));
+    const int max_attempts = replayable ? std::max(policy.maxAttempts, 1) : 1;
+    const bool hedge = m_config.hedging.enabled && idempotent && !spec.output.sink && !spec.output.fd;
+    if (max_attempts > 1 || m_config.hedging.enabled) {
+        m_retryBudget.deposit();
+    }
+
+    for (int attempt = 1;; ++attempt) {
+        // The breaker goes first, so an open one fails fast instead of queueing for a host slot.
+        std::optional<CircuitPass> pass;
+        std::optional<HostSlot> slot;
+        if (m_circuitBreakers || m_hostLimiters) {
+            const std::string_view host = url_host(spec.url);
+            if (m_circuitBreakers && !pass.emplace(m_circuitBreakers->forHost(host)).admitted()) {
+                return std::unexpected(CurlError{CURLE_ABORTED_BY_CALLBACK, "Circuit breaker open for " + std::string(host) + "; request not sent.",
+                                                 HttpErrorPhase::CircuitOpen});
+            }
+            if (m_hostLimiters && !slot.emplace(m_hostLimiters->forHost(host)).acquired()) {
+                return std::unexpected(CurlError{CURLE_ABORTED_BY_CALLBACK, "Too many concurrent requests to " + std::string(host) + "; request rejected.",
+                                                 HttpErrorPhase::Overloaded});
+            }
+        }
+        bool output_started = false;
+        const auto started = std::chrono::steady_clock::now();
+        auto outcome = hedge ? execute_hedged(spec) : execute(spec, output_started);
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        if (pass) {
+            pass->record(outcome ? outcome->statusCode >= 500L : is_transient_error(static_cast<CURLcode>(outcome.error().code)));
+            pass.reset();
+        }
+        if (slot) {
+            slot->record(latency, looks_overloaded(outcome));
+            slot.reset();
+        }
+
+        // A body that already reached a sink or descriptor cannot be taken back.
+        bool retry = attempt < max_attempts && !output_started;
+        std::optional<std::chrono::milliseconds> server_delay;
+        if (outcome) {
+            retry = retry && (idempotent || policy.retryNonIdempotent) &&
+                    std::ranges::find(policy.retryStatusCodes, outcome->statusCode) != policy.retryStatusCodes.end();
+            if (retry) server_delay = retry_after(outcome->headers);
+        } else {
+            const CURLcode code = static_cast<CURLcode>(outcome.error().code);
+            retry = retry && is_transient_error(code) && (idempotent || policy.retryNonIdempotent || is_connect_error(code));
+        }
+        if (!retry || !m_retryBudget.withdraw()) {
+            if (outcome && hedge && !m_config.hedging.delay) {
+                m_getLatencies.record(latency);
+            }
+            return outcome;
+        }
+        if (spec.reuse && outcome) {
+            // Hands the buffers of the discarded response to the next attempt; failed attempts already gave them back.
+            *spec.reuse = std::move(*outcome);
+        }
+        std::this_thread::sleep_for(retry_backoff(policy, attempt, server_delay));
+    }
+}
+
+[[nodiscard]] std::vector<std::expected<HttpResponse, CurlError>> HttpClient::Impl::performBatch(std::span<const HttpRequest> requests) const {
+    static constexpr int POLL_TIMEOUT_MS = 1000;
+
+    std::vector<std::expected<HttpResponse, CurlError>> results(requests.size());
+    if (requests.empty()) {
+        return results;
+    }
+
+    auto multi_deleter = [](CURLM* m) { curl_multi_cleanup(m); };
+    std::unique_ptr<CURLM, decltype(multi_deleter)> multi_ptr(curl_multi_init(), multi_deleter); //NOSONAR
+    if (!multi_ptr) {
+        throw CurlException("Failed to create CURL multi handle.");
+    }
+    CURLM* multi = multi_ptr.get();
+    const std::size_t max_active = std::max<std::size_t>(m_config.batchMaxConcurrency, 1);
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(max_active));
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, m_config.batchMaxHostConnections);
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, m_config.multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+
+    // Running transfers keyed by handle, with the index of the request they belong to.
+    // Declared after the multi handle, so every handle is removed from it first even if an exception escapes.
+    struct ActiveTransfers {
+        CURLM* multi;
+        std::unordered_map<CURL*, std::pair<std::size_t, std::unique_ptr<Transfer>>> transfers;
+        ~ActiveTransfers() {
+            for (const auto& [curl, entry] : transfers) curl_multi_remove_handle(multi, curl);
+        }
+    } active{multi, {}};
+
+    std::size_t next = 0;
+    auto start_pending = [&] {
+        for (; next < requests.size() && active.transfers.size() < max_active; ++next) {
+            const HttpRequest& request = requests[next];
+            try {
+                auto transfer = std::make_unique<Transfer>(m_handlePool);
+                const bool is_post = request.method == HttpMethod::Post;
+                prepare(*transfer, RequestSpec{.url = request.url,
+                                               .headers = request.headers,
+                                               .body = is_post && request.formParts.empty() ? std::optional<std::string_view>(request.body) : std::nullopt,
+                                               .formParts = is_post && !request.formParts.empty() ? &request.formParts : nullptr});
+                CURL* curl = transfer->handle.get();
+                if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+                    throw CurlException("curl_multi_add_handle() failed.");
+                }
+                active.transfers.emplace(curl, std::make_pair(next, std::move(transfer)));
+            } catch (const CurlException& e) {
+                results[next] = std::unexpected(CurlError{CURLE_FAILED_INIT, e.what(), HttpErrorPhase::Setup});
+            }
+        }
+    };
+
+    start_pending();
+    while (!active.transfers.empty()) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int remaining = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &remaining)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            CURL* curl = message->easy_handle;
+            const CURLcode res = message->data.result;
+            curl_multi_remove_handle(multi, curl);
+            auto node = active.transfers.extract(curl);
+            auto& [index, transfer] = node.mapped();
+            record_metrics(*transfer, res);
+            if (res == CURLE_OK) {
+                collect_response_info(*transfer);
+                results[index] = std::move(transfer->response);
+            } else {
+                results[index] = std::unexpected(transfer_error(*transfer, res, "Batch transfer failed: "));
+            }
+        }
+
+        start_pending();
+        if (!active.transfers.empty()) {
+            curl_multi_poll(multi, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+        }
+    }
+    return results;
+}
+
+[[nodiscard]] std::vector<std::expected<void, CurlError>> HttpClient::Impl::warmup(std::span<const std::string> origins,
+                                                                                   std::size_t connectionsPerOrigin) const {
+    struct Progress {
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::size_t pending = 0;
+        std::vector<std::expected<void, CurlError>> results;
+        // Handles warmed by blocking requests, held until the asynchronous requests are done.
+        std::vector<std::unique_ptr<Transfer>> warmed;
+    } progress;
+    const std::size_t per_origin = std::max<std::size_t>(connectionsPerOrigin, 1);
+    progress.results.resize(origins.size());
+    progress.pending = origins.size() * per_origin;
+
+    const std::map<std::string, std::string, std::less<>> no_headers;
+    for (std::size_t i = 0; i < origins.size(); ++i) {
+        for (std::size_t copy = 0; copy < per_origin; ++copy) {
+            performRequestAsync({.url = origins[i], .headers = no_headers, .head = true}, std::nullopt,
+                                [&progress, i](std::expected<HttpResponse, CurlError> result) {
+                // Notified under the lock, since the waiting thread destroys the progress as soon as it sees it finished.
+                std::scoped_lock lock(progress.mutex);
+                if (!result && progress.results[i]) {
+                    progress.results[i] = std::unexpected(std::move(result.error()));
+                }
+                --progress.pending;
+                progress.finished.notify_all();
+            });
+        }
+    }
+
+    // Blocking calls reuse the connections cached in the pooled handle they run on, which the event
+    // loop never fills. Unless connections are shared, up to connectionsPerOrigin pooled handles are
+    // warmed as well, each on its own thread sending a HEAD request to every origin in turn.
+    std::vector<std::jthread> warmers;
+    if (!m_config.shareConnections) {
+        const std::size_t handles = std::min(per_origin, m_config.handlePoolSize);
+        for (std::size_t copy = 0; copy < handles; ++copy) {
+            warmers.emplace_back([this, origins, &progress, &no_headers] {
+                std::vector<std::expected<void, CurlError>> outcome(origins.size());
+                std::unique_ptr<Transfer> transfer;
+                std::size_t i = 0;
+                try {
+                    transfer = std::make_unique<Transfer>(m_handlePool);
+                    for (; i < origins.size(); ++i) {
+                        prepare(*transfer, {.url = origins[i], .headers = no_headers, .head = true});
+                        const CURLcode res = curl_easy_perform(transfer->handle.get());
+                        record_metrics(*transfer, res);
+                        if (res != CURLE_OK) {
+                            outcome[i] = std::unexpected(transfer_error(*transfer, res, "curl_easy_perform() failed: "));
+                        }
+                    }
+                } catch (const CurlException& e) {
+                    outcome[i] = std::unexpected(CurlError{CURLE_FAILED_INIT, e.what(), HttpErrorPhase::Setup});
+                }
+                std::scoped_lock lock(progress.mutex);
+                if (transfer) progress.warmed.push_back(std::move(transfer));
+                for (std::size_t k = 0; k < outcome.size(); ++k) {
+                    if (!outcome[k] && progress.results[k]) {
+                        progress.results[k] = std::unexpected(std::move(outcome[k].error()));
+                    }
+                }
+            });
+        }
+    }
+    // Joined before the results are moved out, since the warmers still write to them.
+    warmers.clear();
+
+    std::unique_lock lock(progress.mutex);
+    progress.finished.wait(lock, [&progress] { return progress.pending == 0; });
+    // Returned to the pool after the handles of the asynchronous requests, so the next blocking calls pick them first.
+    for (auto& transfer : progress.warmed) {
+        CURL* curl = transfer->handle.release();
+        transfer.reset();
+        m_handlePool.promote(curl);
+    }
+    return std::move(progress.results);
+}
+
+[[nodiscard]] HttpDownloadResult HttpClient::Impl::download(const std::string& url, const std::string& path,
+                                                           const HttpDownloadOptions& options) const {
+    // Ranges refer to the encoded representation, so the object is requested without a content coding.
+    std::map<std::string, std::string, std::less<>> headers = options.headers;
+    headers.try_emplace("Accept-Encoding", "identity");
+
+    const HttpResponse head = performRequest({.url = url, .headers = headers, .head = true});
+    if (head.statusCode < 200L || head.statusCode >= 300L) {
+        throw CurlException("Download failed: the HEAD request was answered with HTTP status " + std::to_string(head.statusCode) + ".");
+    }
+    const auto length = head.headers.get("Content-Length");
+    const std::optional<std::uint64_t> content_length = length ? parse_uint64(*length) : std::nullopt;
+    const std::uint64_t size = content_length.value_or(0);
+    const auto accept_ranges = head.headers.get("Accept-Ranges");
+    const bool ranges = accept_ranges && accept_ranges->find("bytes") != std::string_view::npos;
+    // If-Range only accepts strong validators.
+    std::string validator;
+    if (const auto etag = head.headers.get("ETag"); etag && !etag->starts_with("W/")) {
+        validator = *etag;
+    } else if (const auto modified = head.headers.get("Last-Modified")) {
+        validator = *modified;
+    }
+
+    const std::string progress_path = path + ".download";
+    const DownloadFile file(path);
+    if (!ranges || size == 0) {
+        // The object can only be fetched whole, so there is nothing to split or resume.
+        file.resize(0);
+        const HttpResponse response = performRequest({.url = url, .headers = headers, .output = {.fd = file.fd()}});
+        if (response.statusCode < 200L || response.statusCode >= 300L) {
+            throw CurlException("Download failed: the server answered with HTTP status " + std::to_string(response.statusCode) + ".");
+        }
+        std::error_code ignored;
+        std::filesystem::remove(progress_path, ignored);
+        return {.bytes = file.size(), .resumedBytes = 0, .segments = 1};
+    }
+
+    const bool keep_progress = options.resume && !validator.empty();
+    std::optional<std::vector<std::array<std::uint64_t, 3>>> saved;
+    if (keep_progress && file.size() == size) {
+        saved = load_download_progress(progress_path, size, validator);
+    }
+    const std::uint64_t segment_floor = std::max<std::uint64_t>(options.minSegmentBytes, 1);
+    const std::size_t count = saved ? saved->size()
+                                    : static_cast<std::size_t>(std::clamp<std::uint64_t>(size / segment_floor, 1,
+                                                                                         std::max<std::size_t>(options.segments, 1)));
+    std::vector<DownloadSegment> segments(count);
+    std::uint64_t resumed = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        DownloadSegment& segment = segments[i];
+        if (saved) {
+            segment.begin = (*saved)[i][0];
+            segment.end = (*saved)[i][1];
+            segment.written.store((*saved)[i][2], std::memory_order_relaxed);
+            resumed += (*saved)[i][2];
+        } else {
+            segment.begin = i * (size / count);
+            segment.end = i + 1 == count ? size : (i + 1) * (size / count);
+        }
+        segment.done = segment.remaining() == 0;
+    }
+    if (!saved) {
+        file.resize(size);
+    }
+
+    const std::string no_progress;
+    const std::string& kept_progress = keep_progress ? progress_path : no_progress;
+    save_download_progress(kept_progress, size, validator, segments);
+    fetch_segments(url, headers, validator, std::max(options.maxAttemptsPerSegment, 1), options.priority, file, segments, kept_progress, size);
+    std::error_code ignored;
+    std::filesystem::remove(progress_path, ignored);
+    return {.bytes = size, .resumedBytes = resumed, .segments = count};
+}
+
+// Fetches the unfinished segments in parallel on the event loop and retries failed ones from where they
+// stopped. The calling thread only coordinates and saves the progress, at least once per second.
+void HttpClient::Impl::fetch_segments(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers,
+                                      std::string_view validator, int maxAttempts, HttpPriority priority, const DownloadFile& file,
+                                      std::vector<DownloadSegment>& segments, const std::string& progressPath,
+                                      std::uint64_t size) const {
+    static constexpr std::chrono::seconds PROGRESS_INTERVAL{1};
+    struct Run {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t running = 0;
+        std::vector<std::pair<std::size_t, std::expected<HttpResponse, CurlError>>> finished;
+    } run;
+
+    // Address-stable sinks, since in-flight transfers point at them.
+    std::vector<HttpBodySink> sinks;
+    sinks.reserve(segments.size());
+    for (DownloadSegment& segment : segments) {
+        sinks.emplace_back([&segment, &file](std::span<const char> chunk) {
+            const std::uint64_t written = segment.written.load(std::memory_order_relaxed);
+            if (chunk.size() > segment.end - segment.begin - written || !file.write_at(segment.begin + written, chunk)) {
+                return false;
+            }
+            segment.written.store(written + chunk.size(), std::memory_order_release);
+            return true;
+        });
+    }
+
+    const auto start = [&](std::size_t index) {
+        DownloadSegment& segment = segments[index];
+        ++segment.attempts;
+        std::map<std::string, std::string, std::less<>> range_headers = headers;
+        std::string range = "bytes=";
+        append_number(range, segment.begin + segment.written.load(std::memory_order_acquire));
+        range.append("-");
+        append_number(range, segment.end - 1);
+        range_headers.insert_or_assign("Range", std::move(range));
+        if (!validator.empty()) {
+            // A changed object is then answered with 200 instead of mixing two versions in one file.
+            range_headers.insert_or_assign("If-Range", std::string(validator));
+        }
+        {
+            std::scoped_lock lock(run.mutex);
+            ++run.running;
+        }
+        segment.ticket = performRequestAsync({.url = url, .headers = range_headers, .output = {.sink = &sinks[index], .fd = std::nullopt, .partialOnly = true}, .priority = priority},
+                                             std::nullopt, [&run, index](std::expected<HttpResponse, CurlError> result) {
+            // Notified under the lock, since the waiting thread destroys the run as soon as it sees it finished.
+            std::scoped_lock lock(run.mutex);
+            run.finished.emplace_back(index, std::move(result));
+            --run.running;
+            run.changed.notify_all();
+        });
+    };
+
+    std::optional<std::string> failure;
+    std::exception_ptr error;
+    // Set once a range request shows that the object changed, which makes the saved progress worthless.
+    bool changed = false;
+    const auto fail = [&](std::string message) {
+        if (failure) return;
+        failure = std::move(message);
+        for (const DownloadSegment& segment : segments) {
+            if (!segment.done && segment.ticket != 0) engine().cancel(segment.ticket);
+        }
+    };
+    const auto finish = [&](std::size_t index, std::expected<HttpResponse, CurlError>& result) {
+        DownloadSegment& segment = segments[index];
+        if (result && result->statusCode == 206L && segment.remaining() == 0) {
+            segment.done = true;
+            return;
+        }
+        if (failure) return;
+        if (result && result->statusCode == 200L) {
+            // With If-Range, a full response means the validator no longer matches, and retrying would
+            // only get the same answer. Without one, the server simply ignores ranges.
+            if (validator.empty()) {
+                fail("the server ignored the range request.");
+            } else {
+                changed = true;
+                fail("the object changed on the server; the partial download was discarded.");
+            }
+            return;
+        }
+        const auto& retry_codes = m_config.retry.retryStatusCodes;
+        const bool retryable = !result || result->statusCode == 206L ||
+                               std::ranges::find(retry_codes, result->statusCode) != retry_codes.end();
+        if (retryable && segment.attempts < maxAttempts) {
+            start(index);
+        } else if (result) {
+            fail("a range request was answered with HTTP status " + std::to_string(result->statusCode) + ".");
+        } else {
+            fail(std::move(result.error().message));
+        }
+    };
+
+    try {
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            if (!segments[i].done) start(i);
+        }
+    } catch (...) { // NOSONAR: started segments must finish before their state goes out of scope
+        error = std::current_exception();
+        fail("the download could not be started.");
+    }
+    std::unique_lock lock(run.mutex);
+    while (run.running > 0 || !run.finished.empty()) {
+        const bool woken = run.changed.wait_for(lock, PROGRESS_INTERVAL, [&run] { return !run.finished.empty(); });
+        auto finished = std::exchange(run.finished, {});
+        lock.unlock();
+        for (auto& [index, result] : finished) {
+            try {
+                finish(index, result);
+            } catch (...) { // NOSONAR: see above
+                if (!error) error = std::current_exception();
+                fail("a failed segment could not be restarted.");
+            }
+        }
+        if (!changed && (!woken || failure)) {
+            save_download_progress(progressPath, size, validator, segments);
+        }
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (changed) {
+        std::error_code ignored;
+        std::filesystem::remove(progressPath, ignored);
+    } else if (error || failure) {
+        save_download_progress(progressPath, size, validator, segments);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (failure) {
+        throw CurlException("Download failed: " + *failure);
+    }
+}
+
+[[nodiscard]] MultiEngine& HttpClient::Impl::engine() const {
+    std::call_once(m_engineOnce, [this] { m_engine = std::make_unique<MultiEngine>(m_config.multiplex, m_config.scheduler); });
+    return *m_engine;
+}
+
+std::uint64_t HttpClient::Impl::performRequestAsync(const RequestSpec& spec,
+                                           std::optional<std::string> ownedBody,
+                                           HttpCompletionHandler onComplete) const {
+    std::unique_ptr<Transfer> transfer;
+    try {
+        transfer = std::make_unique<Transfer>(m_handlePool);
+        RequestSpec owned_spec = spec;
+        if (ownedBody) {
+            transfer->ownedBody = std::move(*ownedBody);
+            owned_spec.body = transfer->ownedBody;
+        }
+        prepare(*transfer, owned_spec);
+    } catch (const CurlException& e) {
+        onComplete(std::unexpected(CurlError{CURLE_FAILED_INIT, e.what(), HttpErrorPhase::Setup}));
+        return 0;
+    }
+
+    CURL* curl = transfer->handle.get();
+    return engine().submit(curl, spec.priority, [transfer = std::move(transfer), onComplete = std::move(onComplete)](CURLcode res) mutable {
+        std::expected<HttpResponse, CurlError> result;
+        if (res == CURLE_WRITE_ERROR && transfer->rangeIgnored) res = CURLE_OK;
+        record_metrics(*transfer, res);
+        if (res == CURLE_OK) {
+            collect_response_info(*transfer);
+            result = std::move(transfer->response);
+        } else {
+            result = std::unexpected(transfer_error(*transfer, res, "Asynchronous transfer failed: "));
+        }
+        // Release the handle before running user code, so it can be reused by requests the handler starts.
+        transfer.reset();
+        try {
+            onComplete(std::move(result));
+        } catch (...) { // NOSONAR: an escaping exception must not take down the event loop
+        }
+    });
+}
+
+// --- Public HttpClient methods ---
+
+HttpClient::HttpClient(HttpClientConfig config) : pimpl(std::make_unique<Impl>(std::move(config))) {}
+HttpClient::~HttpClient() = default;
+HttpClient::HttpClient(HttpClient&&) noexcept = default;
+HttpClient& HttpClient::operator=(HttpClient&&) noexcept = default;
+
+[[nodiscard]] HttpResponse HttpClient::get(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers});
+}
+
+[[nodiscard]] HttpResponse HttpClient::get(const std::string& url, const PreparedHeaders& headers) const {
+    return pimpl->performRequest({.url = url, .headers = {}, .preparedHeaders = &headers});
+}
+
+[[nodiscard]] std::expected<HttpResponse, HttpError> HttpClient::tryGet(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->tryPerformRequest({.url = url, .headers = headers});
+}
+
+[[nodiscard]] std::expected<HttpResponse, HttpError> HttpClient::tryGet(const std::string& url, const PreparedHeaders& headers) const {
+    return pimpl->tryPerformRequest({.url = url, .headers = {}, .preparedHeaders = &headers});
+}
+
+[[nodiscard]] std::shared_ptr<const HttpResponse> HttpClient::getShared(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers) const {
+    auto result = pimpl->performShared({.url = url, .headers = headers});
+    if (!result) throw_error(result.error());
+    return std::move(*result);
+}
+
+[[nodiscard]] std::shared_ptr<const HttpResponse> HttpClient::getShared(const std::string& url, const PreparedHeaders& headers) const {
+    auto result = pimpl->performShared({.url = url, .headers = {}, .preparedHeaders = &headers});
+    if (!result) throw_error(result.error());
+    return std::move(*result);
+}
+
+void HttpClient::getInto(const std::string& url, HttpResponse& response, const std::map<std::string, std::string, std::less<>>& headers) const {
+    response = pimpl->performRequest({.url = url, .headers = headers, .reuse = &response});
+}
+
+void HttpClient::getInto(const std::string& url, HttpResponse& response, const PreparedHeaders& headers) const {
+    response = pimpl->performRequest({.url = url, .headers = {}, .preparedHeaders = &headers, .reuse = &response});
+}
+
+[[nodiscard]] HttpResponse HttpClient::get(const std::string& url, const HttpBodySink& sink, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers, .output = {.sink = &sink, .fd = std::nullopt}});
+}
+
+[[nodiscard]] HttpResponse HttpClient::get(const std::string& url, HttpFileDescriptorSink sink, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers, .output = {.fd = sink.fd}});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, std::string_view body, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers, .body = body});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, std::string_view body, const PreparedHeaders& headers) const {
+    return pimpl->performRequest({.url = url, .headers = {}, .body = body, .preparedHeaders = &headers});
+}
+
+[[nodiscard]] std::expected<HttpResponse, HttpError> HttpClient::tryPost(const std::string& url, std::string_view body, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->tryPerformRequest({.url = url, .headers = headers, .body = body});
+}
+
+[[nodiscard]] std::expected<HttpResponse, HttpError> HttpClient::tryPost(const std::string& url, std::string_view body, const PreparedHeaders& headers) const {
+    return pimpl->tryPerformRequest({.url = url, .headers = {}, .body = body, .preparedHeaders = &headers});
+}
+
+void HttpClient::postInto(const std::string& url, std::string_view body, HttpResponse& response, const std::map<std::string, std::string, std::less<>>& headers) const {
+    response = pimpl->performRequest({.url = url, .headers = headers, .body = body, .reuse = &response});
+}
+
+void HttpClient::postInto(const std::string& url, std::string_view body, HttpResponse& response, const PreparedHeaders& headers) const {
+    response = pimpl->performRequest({.url = url, .headers = {}, .body = body, .preparedHeaders = &headers, .reuse = &response});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, std::span<const std::byte> body, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return post(url, std::string_view(reinterpret_cast<const char*>(body.data()), body.size()), headers); // NOSONAR: byte view of the same memory
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, std::span<const std::byte> body, const PreparedHeaders& headers) const {
+    return post(url, std::string_view(reinterpret_cast<const char*>(body.data()), body.size()), headers); // NOSONAR: byte view of the same memory
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const HttpBodySource& source, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers, .source = &source});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const HttpBodySource& source, const PreparedHeaders& headers) const {
+    return pimpl->performRequest({.url = url, .headers = {}, .source = &source, .preparedHeaders = &headers});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const std::vector<HttpFormPart>& formParts, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return pimpl->performRequest({.url = url, .headers = headers, .formParts = &formParts});
+}
+
+[[nodiscard]] HttpResponse HttpClient::post(const std::string& url, const std::vector<HttpFormPart>& formParts, const PreparedHeaders& headers) const {
+    return pimpl->performRequest({.url = url, .headers = {}, .formParts = &formParts, .preparedHeaders = &headers});
+}
+
+[[nodiscard]] PreparedHeaders HttpClient::prepareHeaders(const std::map<std::string, std::string, std::less<>>& headers) const {
+    return PreparedHeaders(pimpl->build_headers(headers));
+}
+
+[[nodiscard]] std::vector<std::expected<HttpResponse, CurlError>> HttpClient::batch(std::span<const HttpRequest> requests) const {
+    return pimpl->performBatch(requests);
+}
+
+[[nodiscard]] std::vector<std::expected<void, CurlError>> HttpClient::warmup(std::span<const std::string> origins, std::size_t connectionsPerOrigin) const {
+    return pimpl->warmup(origins, connectionsPerOrigin);
+}
+
+[[nodiscard]] HttpDownloadResult HttpClient::download(const std::string& url, const std::string& path, const HttpDownloadOptions& options) const {
+    return pimpl->download(url, path, options);
+}
+
+namespace {
+
+// Adapts a std::future to the completion-handler form of the asynchronous API.
+std::pair<std::future<HttpResponse>, HttpCompletionHandler> make_future_handler() {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    HttpCompletionHandler handler = [promise](std::expected<HttpResponse, CurlError> result) {
+        if (result) {
+            promise->set_value(std::move(*result));
+        } else {
+            promise->set_exception(std::make_exception_ptr(CurlException(result.error().message)));
+        }
+    };
+    return {std::move(future), std::move(handler)};
+}
+
+} // namespace
+
+[[nodiscard]] std::future<HttpResponse> HttpClient::getAsync(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    auto [future, handler] = make_future_handler();
+    pimpl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::nullopt, std::move(handler));
+    return std::move(future);
+}
+
+void HttpClient::getAsync(const std::string& url, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    pimpl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::nullopt, std::move(onComplete));
+}
+
+[[nodiscard]] std::future<HttpResponse> HttpClient::postAsync(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    auto [future, handler] = make_future_handler();
+    pimpl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::move(body), std::move(handler));
+    return std::move(future);
+}
+
+void HttpClient::postAsync(const std::string& url, std::string body, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    pimpl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::move(body), std::move(onComplete));
+}
+
+[[nodiscard]] std::future<HttpResponse> HttpClient::postAsync(const std::string& url, HttpUploadStream& body, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    auto [future, handler] = make_future_handler();
+    pimpl->performRequestAsync({.url = url, .headers = headers, .upload = &body, .priority = priority}, std::nullopt, std::move(handler));
+    return std::move(future);
+}
+
+void HttpClient::postAsync(const std::string& url, HttpUploadStream& body, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    pimpl->performRequestAsync({.url = url, .headers = headers, .upload = &body, .priority = priority}, std::nullopt, std::move(onComplete));
+}
+
+[[nodiscard]] std::future<HttpResponse> HttpClient::postAsync(const std::string& url, const std::vector<HttpFormPart>& formParts, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    auto [future, handler] = make_future_handler();
+    pimpl->performRequestAsync({.url = url, .headers = headers, .formParts = &formParts, .priority = priority}, std::nullopt, std::move(handler));
+    return std::move(future);
+}
+
+void HttpClient::postAsync(const std::string& url, const std::vector<HttpFormPart>& formParts, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    pimpl->performRequestAsync({.url = url, .headers = headers, .formParts = &formParts, .priority = priority}, std::nullopt, std::move(onComplete));
+}
+
+[[nodiscard]] HttpAwaitable HttpClient::coGet(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    return HttpAwaitable([impl = pimpl.get(), url, headers, priority](HttpCompletionHandler onComplete) {
+        impl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::nullopt, std::move(onComplete));
+    });
+}
+
+[[nodiscard]] HttpAwaitable HttpClient::coPost(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    return HttpAwaitable([impl = pimpl.get(), url, body = std::move(body), headers, priority](HttpCompletionHandler onComplete) mutable {
+        impl->performRequestAsync({.url = url, .headers = headers, .priority = priority}, std::move(body), std::move(onComplete));
+    });
+}
+
+[[nodiscard]] HttpAwaitable HttpClient::coPost(const std::string& url, std::vector<HttpFormPart> formParts, const std::map<std::string, std::string, std::less<>>& headers, HttpPriority priority) const {
+    return HttpAwaitable([impl = pimpl.get(), url, formParts = std::move(formParts), headers, priority](HttpCompletionHandler onComplete) {
+        impl->performRequestAsync({.url = url, .headers = headers, .formParts = &formParts, .priority = priority}, std::nullopt, std::move(onComplete));
+    });
+}
+
+[[nodiscard]] HttpMetricsSnapshot HttpClient::metrics() const {
+    return pimpl->metrics();
+}
+
+// --- HttpAwaitable methods ---
+
+void HttpAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    // The coroutine may be resumed, and this awaitable destroyed, before the starter returns,
+    // so the starter is moved out first and no member is touched after it is called.
+    Starter start = std::move(m_start);
+    start([this, handle](std::expected<HttpResponse, CurlError> result) {
+        m_result.emplace(std::move(result));
+        handle.resume();
+    });
+}
+
+HttpResponse HttpAwaitable::await_resume() {
+    if (!m_result) {
+        throw CurlException("HttpAwaitable resumed without a result.");
+    }
+    if (!*m_result) {
+        throw_error(m_result->error());
+    }
+    return std::move(**m_result);
 }
@@ -16,6 +16,17 @@
 #include <memory>
 #include <functional> // For std::less
 #include <variant>    // For std::variant
+#include <future>     // For std::future
+#include <expected>   // For std::expected
+#include <coroutine>  // For std::coroutine_handle
+#include <span>       // For std::span
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <chrono>     // For std::chrono::microseconds
+#include <array>
+#include <atomic>
 
 /**
  * @class CurlException
@@ -26,6 +37,187 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+/**
+ * @class HttpOverloadedException
+ * @brief Thrown when the per-host concurrency limits reject a request before it is sent (see HttpHostLimits).
+ *
+ * Derives from CurlException, so existing handlers keep catching it; catch it first to shed load
+ * differently from transport failures.
+ */
+class HttpOverloadedException : public CurlException {
+public:
+    using CurlException::CurlException;
+};
+
+/**
+ * @class HttpCircuitOpenException
+ * @brief Thrown without sending the request while the circuit breaker of its host is open (see HttpCircuitBreakerPolicy).
+ */
+class HttpCircuitOpenException : public CurlException {
+public:
+    using CurlException::CurlException;
+};
+
+/**
+ * @class HttpHeaders
+ * @brief Compact, case-insensitive container for response headers.
+ *
+ * All header text is stored in one contiguous buffer, indexed by a small vector of entries kept sorted
+ * by name. Once the buffers have grown, parsing a header line allocates nothing. Names compare
+ * case-insensitively. If a name occurs more than once, lookups return the last value received, like the
+ * std::map this container replaces. Iteration visits every header, ordered by name. Code written against
+ * that map can keep using it through asMap().
+ */
+class HttpHeaders {
+public:
+    /// @brief A header as a name/value pair of views into the container's buffer.
+    using value_type = std::pair<std::string_view, std::string_view>;
+    /// @brief The map type HttpResponse::headers had before this container, see asMap().
+    using Map = std::map<std::string, std::string, std::less<>>;
+
+    HttpHeaders() = default;
+    ~HttpHeaders();
+    HttpHeaders(const HttpHeaders& other);
+    HttpHeaders& operator=(const HttpHeaders& other);
+    HttpHeaders(HttpHeaders&& other) noexcept;
+    HttpHeaders& operator=(HttpHeaders&& other) noexcept;
+
+    /**
+     * @class const_iterator
+     * @brief Iterates over the headers, yielding name/value views.
+     */
+    class const_iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using value_type = HttpHeaders::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        const_iterator() = default;
+        [[nodiscard]] value_type operator*() const { return m_headers->entryAt(m_index); }
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator previous = *this; ++m_index; return previous; }
+        [[nodiscard]] bool operator==(const const_iterator& other) const noexcept { return m_index == other.m_index; }
+
+    private:
+        friend class HttpHeaders;
+        const_iterator(const HttpHeaders* headers, std::size_t index) : m_headers(headers), m_index(index) {}
+        const HttpHeaders* m_headers = nullptr;
+        std::size_t m_index = 0;
+    };
+
+    /**
+     * @brief Parses a raw "Name: value" header line (as received from libcurl) and adds it.
+     * @param line The header line, with or without its trailing CRLF. Lines without a colon are ignored.
+     */
+    void append(std::string_view line);
+
+    /**
+     * @brief Adds a header.
+     * @param name The header name.
+     * @param value The header value.
+     */
+    void add(std::string_view name, std::string_view value);
+
+    /// @brief Removes all headers but keeps the allocated storage for reuse.
+    void clear() noexcept;
+
+    /**
+     * @brief Looks up a header value by name, ignoring case.
+     * @param name The header name.
+     * @return The last value received for the name, or std::nullopt.
+     */
+    [[nodiscard]] std::optional<std::string_view> get(std::string_view name) const;
+
+    /**
+     * @brief Looks up a header value by name, ignoring case.
+     * @param name The header name.
+     * @return The last value received for the name.
+     * @throws std::out_of_range if the header is not present.
+     */
+    [[nodiscard]] std::string_view at(std::string_view name) const;
+
+    /**
+     * @brief Finds a header by name, ignoring case.
+     * @param name The header name.
+     * @return An iterator to the last header received with that name, or end().
+     */
+    [[nodiscard]] const_iterator find(std::string_view name) const;
+
+    /// @brief Returns true if a header with the given name (ignoring case) is present.
+    [[nodiscard]] bool contains(std::string_view name) const { return get(name).has_value(); }
+    /// @brief Returns how many headers with the given name (ignoring case) are present.
+    [[nodiscard]] std::size_t count(std::string_view name) const;
+    /// @brief Returns the number of headers, counting repeated names separately.
+    [[nodiscard]] std::size_t size() const noexcept { return m_entries.size(); }
+    /// @brief Returns true if there are no headers.
+    [[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+    [[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const noexcept { return {this, m_entries.size()}; }
+
+    /**
+     * @brief Returns the headers as the std::map of the previous map-based API.
+     *
+     * The map is built on the first call and kept until the headers change, so later calls are free.
+     * It may be called concurrently, e.g. on a response shared by HttpClient::getShared.
+     * @return A map from header name, as received, to its last received value.
+     */
+    [[nodiscard]] const Map& asMap() const;
+
+private:
+    struct Entry {
+        std::uint32_t nameOffset;
+        std::uint32_t nameLength;
+        std::uint32_t valueOffset;
+        std::uint32_t valueLength;
+    };
+
+    [[nodiscard]] value_type entryAt(std::size_t index) const;
+    [[nodiscard]] std::string_view nameOf(const Entry& entry) const;
+    // Returns the first entry whose name sorts after `name`.
+    [[nodiscard]] std::vector<Entry>::const_iterator upperBound(std::string_view name) const;
+    // Returns the index of the last entry named `name`, or std::string_view::npos if there is none.
+    [[nodiscard]] std::size_t lastIndexOf(std::string_view name) const;
+
+    // Drops the map built by asMap() once the headers it was built from change.
+    void dropMap() noexcept;
+
+    std::string m_arena;
+    std::vector<Entry> m_entries;
+    mutable std::atomic<const Map*> m_map{nullptr};
+};
+
+/**
+ * @struct HttpTimings
+ * @brief Where the time of a request went, as reported by libcurl.
+ *
+ * Each phase is measured from the start of the transfer, so the values are cumulative:
+ * connect includes nameLookup, startTransfer includes preTransfer, and so on.
+ */
+struct HttpTimings {
+    /// @brief Until name resolution completed.
+    std::chrono::microseconds nameLookup{0};
+    /// @brief Until the TCP (or QUIC) connection was established.
+    std::chrono::microseconds connect{0};
+    /// @brief Until the TLS handshake completed; zero for plain-text connections.
+    std::chrono::microseconds appConnect{0};
+    /// @brief Until the request was about to be sent.
+    std::chrono::microseconds preTransfer{0};
+    /// @brief Until the first response byte arrived (time to first byte).
+    std::chrono::microseconds startTransfer{0};
+    /// @brief The whole transfer, including redirects.
+    std::chrono::microseconds total{0};
+    /// @brief Time spent following redirects before the final transfer started.
+    std::chrono::microseconds redirect{0};
+    /// @brief Request body bytes sent.
+    std::uint64_t bytesUploaded = 0;
+    /// @brief Response body bytes received.
+    std::uint64_t bytesDownloaded = 0;
+    /// @brief True if the request went over an existing connection instead of opening a new one.
+    bool connectionReused = false;
+    /// @brief The negotiated HTTP version as major * 10 + minor (10, 11, 20 or 30), or 0 if unknown.
+    int httpVersion = 0;
+};
+
 /**
  * @struct HttpResponse
  * @brief Represents an HTTP response from a server.
@@ -35,8 +227,428 @@ struct HttpResponse {
     long statusCode;
     /// @brief The body of the HTTP response.
     std::string body;
-    /// @brief A map of response headers.
+    /// @brief The response headers, with case-insensitive lookup. headers.asMap() gives the std::map of earlier versions.
+    HttpHeaders headers;
+    /// @brief The timing breakdown and connection details of the transfer.
+    HttpTimings timings;
+};
+
+/**
+ * @brief Receives a response body chunk by chunk as it arrives.
+ *
+ * Return true to continue the transfer or false to abort it.
+ */
+using HttpBodySink = std::function<bool(std::span<const char>)>;
+
+/**
+ * @struct HttpFileDescriptorSink
+ * @brief Streams a response body straight into an open, writable file descriptor.
+ */
+struct HttpFileDescriptorSink {
+    /// @brief The descriptor to write to. It is not closed by the client.
+    int fd;
+};
+
+/**
+ * @enum HttpPriority
+ * @brief The scheduling class of an asynchronous request, see HttpSchedulerPolicy.
+ */
+enum class HttpPriority {
+    /// @brief Latency-critical requests, started first.
+    Critical,
+    /// @brief The default class.
+    Normal,
+    /// @brief Background transfers that may wait behind everything else.
+    Bulk
+};
+
+/**
+ * @struct HttpDownloadOptions
+ * @brief How HttpClient::download splits and retries the transfer of a large object.
+ */
+struct HttpDownloadOptions {
+    /// @brief The most byte ranges fetched in parallel. Defaults to 4.
+    std::size_t segments = 4;
+    /// @brief The smallest range worth its own request; smaller objects use fewer segments. Defaults to 8 MiB.
+    std::uint64_t minSegmentBytes = 8ULL * 1024 * 1024;
+    /// @brief Attempts per segment, each continuing where the previous one stopped. Defaults to 3.
+    int maxAttemptsPerSegment = 3;
+    /// @brief Keeps the progress in "<path>.download", so a failed download of the same object continues where it
+    /// stopped instead of starting over. Needs an ETag or Last-Modified header to detect changes. Defaults to true.
+    bool resume = true;
+    /// @brief Headers sent with the HEAD and every range request.
     std::map<std::string, std::string, std::less<>> headers;
+    /// @brief The scheduling class of the range requests, see HttpSchedulerPolicy. Defaults to Bulk.
+    HttpPriority priority = HttpPriority::Bulk;
+};
+
+/**
+ * @struct HttpDownloadResult
+ * @brief Describes a completed HttpClient::download.
+ */
+struct HttpDownloadResult {
+    /// @brief The size of the downloaded file in bytes.
+    std::uint64_t bytes = 0;
+    /// @brief The bytes kept from an earlier, interrupted download and not fetched again.
+    std::uint64_t resumedBytes = 0;
+    /// @brief The number of byte ranges the object was split into; 1 if the server does not support ranges.
+    std::size_t segments = 0;
+};
+
+/**
+ * @struct HttpBodySource
+ * @brief Produces a request body on demand, so the whole payload never has to be held in memory.
+ */
+struct HttpBodySource {
+    /// @brief Fills the buffer with the next bytes of the body and returns how many were written; 0 ends the body.
+    /// An exception thrown here aborts the transfer and is rethrown to the caller.
+    std::function<std::size_t(std::span<char>)> read;
+    /// @brief Total body size in bytes, sent as Content-Length. When unset, the body is sent chunked.
+    std::optional<std::uint64_t> contentLength;
+};
+
+/**
+ * @class HttpUploadStream
+ * @brief A bounded pipe that a producer writes a request body into while HttpClient::postAsync uploads it.
+ *
+ * The body is sent with chunked transfer encoding (or as a stream of HTTP/2 data frames) as it is written.
+ * Backpressure works both ways: write() blocks while capacity bytes are still waiting to be sent, so a fast
+ * producer is held to the speed of the network, and while the pipe is empty the upload is paused instead
+ * of polling the producer, then resumed by the next write() or close(). A stream carries a single request,
+ * and HttpClientConfig::requestTimeoutMs still bounds the whole upload, pauses included.
+ */
+class HttpUploadStream {
+public:
+    /**
+     * @brief Creates an empty stream.
+     * @param capacity The most bytes buffered ahead of the upload. Defaults to 256 KiB.
+     */
+    explicit HttpUploadStream(std::size_t capacity = 256 * 1024);
+    ~HttpUploadStream();
+
+    HttpUploadStream(const HttpUploadStream&) = delete;
+    HttpUploadStream& operator=(const HttpUploadStream&) = delete;
+    HttpUploadStream(HttpUploadStream&&) = delete;
+    HttpUploadStream& operator=(HttpUploadStream&&) = delete;
+
+    /**
+     * @brief Appends bytes to the body, blocking while the buffer is full.
+     * @param data The bytes to send.
+     * @return False if the request ended (it failed, or the stream was closed or aborted) before all bytes were taken.
+     */
+    bool write(std::string_view data);
+
+    /// @brief Appends binary data to the body, see write(std::string_view).
+    bool write(std::span<const std::byte> data) { return write(std::string_view(reinterpret_cast<const char*>(data.data()), data.size())); } // NOSONAR: bytes are sent as-is
+
+    /// @brief Ends the body once the buffered bytes are sent.
+    void close();
+
+    /// @brief Fails the request without sending the rest of the body. Blocked writers return false.
+    void abort();
+
+private:
+    friend class HttpClient;
+    struct State;
+    std::shared_ptr<State> m_state;
+};
+
+/**
+ * @enum HttpErrorPhase
+ * @brief Where a failed request stopped, see CurlError::phase.
+ */
+enum class HttpErrorPhase {
+    /// @brief The request could not be set up, e.g. a malformed URL or an unsupported option.
+    Setup,
+    /// @brief The host name could not be resolved.
+    Dns,
+    /// @brief No connection could be established.
+    Connect,
+    /// @brief The TLS handshake or certificate verification failed.
+    Tls,
+    /// @brief The connection failed while the request or response was being sent.
+    Transfer,
+    /// @brief A configured timeout expired; the timings show how far the request got.
+    Timeout,
+    /// @brief The per-host limits rejected the request before it was sent (see HttpHostLimits).
+    Overloaded,
+    /// @brief The circuit breaker of the host was open, so the request was not sent (see HttpCircuitBreakerPolicy).
+    CircuitOpen
+};
+
+/**
+ * @struct CurlError
+ * @brief Describes a failed transfer without throwing.
+ */
+struct CurlError {
+    /// @brief The libcurl CURLcode reported for the failure; CURLE_ABORTED_BY_CALLBACK for requests the
+    /// Overloaded and CircuitOpen phases kept from being sent.
+    int code;
+    /// @brief A human-readable description of the failure.
+    std::string message;
+    /// @brief Where the request stopped.
+    HttpErrorPhase phase = HttpErrorPhase::Transfer;
+    /// @brief How far the last attempt got before it failed; all zero if it was never started.
+    HttpTimings timings{};
+};
+
+/// @brief The error half of the non-throwing HttpClient::tryGet and HttpClient::tryPost calls.
+using HttpError = CurlError;
+
+/**
+ * @brief Completion callback for asynchronous requests.
+ *
+ * Invoked exactly once with either the response or the error, normally on the client's event-loop thread
+ * (or on the calling thread if the request cannot be set up).
+ * It should return quickly, since it blocks every other transfer of the client while it runs.
+ * Exceptions thrown by the callback are discarded.
+ */
+using HttpCompletionHandler = std::function<void(std::expected<HttpResponse, CurlError>)>;
+
+/**
+ * @class HttpAwaitable
+ * @brief Awaitable handle for a request started with HttpClient::coGet or HttpClient::coPost.
+ *
+ * The request is started when the awaitable is co_awaited. The awaiting coroutine is resumed on the
+ * client's event-loop thread, and the co_await expression yields the HttpResponse or throws CurlException,
+ * exactly like the blocking API.
+ */
+class [[nodiscard]] HttpAwaitable {
+public:
+    /// @brief Starts the request and arranges for the handler to be called on completion.
+    using Starter = std::function<void(HttpCompletionHandler)>;
+
+    /**
+     * @brief Constructs an awaitable that runs the given starter when awaited.
+     * @param start The function that submits the request to the client's event loop.
+     */
+    explicit HttpAwaitable(Starter start) : m_start(std::move(start)) {}
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    HttpResponse await_resume();
+
+private:
+    Starter m_start;
+    std::optional<std::expected<HttpResponse, CurlError>> m_result;
+};
+
+/**
+ * @enum HttpVersion
+ * @brief The HTTP protocol version an HttpClient requests.
+ */
+enum class HttpVersion {
+    /// @brief Let libcurl pick its build default.
+    Default,
+    /// @brief HTTP/1.1 only.
+    Http1_1,
+    /// @brief HTTP/2 over TLS (negotiated with ALPN), HTTP/1.1 for plain-text URLs.
+    Http2Tls,
+    /// @brief HTTP/2 without the HTTP/1.1 upgrade, for servers known to speak cleartext HTTP/2.
+    Http2PriorKnowledge,
+    /// @brief HTTP/3 over QUIC, falling back to older versions if it cannot be used. Requires an HTTP/3 enabled libcurl.
+    Http3
+};
+
+/**
+ * @enum HttpTlsVersion
+ * @brief A TLS protocol version, used to bound the versions an HttpClient negotiates.
+ */
+enum class HttpTlsVersion {
+    /// @brief TLS 1.2.
+    Tls1_2,
+    /// @brief TLS 1.3.
+    Tls1_3
+};
+
+/// @brief libcurl's header list type, forward-declared so the header does not depend on curl/curl.h.
+struct curl_slist;
+
+/**
+ * @class PreparedHeaders
+ * @brief A request header list that is built once and reused across requests.
+ *
+ * Owns the underlying libcurl header list, so sending it costs no string building or allocation
+ * per request. It is immutable after construction and can be shared between threads. The headers
+ * are sent exactly as prepared; use HttpClient::prepareHeaders to include the client's default headers.
+ *
+ * There is deliberately no constructor taking a map, so braced header lists passed to HttpClient::get
+ * and HttpClient::post keep resolving to the std::map overloads.
+ */
+class PreparedHeaders {
+public:
+    /**
+     * @brief Builds a header list from a map, without any client default headers.
+     * @param headers The request headers to prepare.
+     * @return The prepared header list.
+     * @throws CurlException if the list cannot be allocated.
+     */
+    [[nodiscard]] static PreparedHeaders fromMap(const std::map<std::string, std::string, std::less<>>& headers);
+
+    ~PreparedHeaders();
+
+    PreparedHeaders(const PreparedHeaders&) = delete;
+    PreparedHeaders& operator=(const PreparedHeaders&) = delete;
+    PreparedHeaders(PreparedHeaders&& other) noexcept;
+    PreparedHeaders& operator=(PreparedHeaders&& other) noexcept;
+
+    /// @brief Returns true if the list contains no headers.
+    [[nodiscard]] bool empty() const noexcept { return m_list == nullptr; }
+
+private:
+    friend class HttpClient;
+    explicit PreparedHeaders(curl_slist* list) noexcept : m_list(list) {}
+    curl_slist* m_list = nullptr;
+};
+
+/**
+ * @struct HttpUnixSocket
+ * @brief A Unix domain socket that requests to an origin are sent over instead of TCP.
+ */
+struct HttpUnixSocket {
+    /// @brief The socket path, or the name of an abstract socket (without the leading NUL byte).
+    std::string path;
+    /// @brief Connects to a Linux abstract socket instead of a socket file. Defaults to false.
+    bool abstract = false;
+};
+
+/**
+ * @struct HttpRetryPolicy
+ * @brief When and how often the blocking get and post calls repeat a failed request.
+ *
+ * A request is retried when it fails with a transient transport error (the connection could not be
+ * opened, timed out or was dropped) or with one of retryStatusCodes. The wait before attempt n is
+ * initialBackoff * backoffMultiplier^(n-2), capped at maxBackoff, or the server's Retry-After seconds
+ * when those are longer (still capped at maxBackoff). Asynchronous, coroutine and batch requests are
+ * not retried.
+ */
+struct HttpRetryPolicy {
+    /// @brief The total number of attempts including the first one. Defaults to 1 (retries disabled).
+    int maxAttempts = 1;
+    /// @brief The wait before the first retry. Defaults to 100ms.
+    std::chrono::milliseconds initialBackoff{100};
+    /// @brief The longest wait between two attempts. Defaults to 2000ms.
+    std::chrono::milliseconds maxBackoff{2000};
+    /// @brief The factor the wait grows by after every retry. Defaults to 2.
+    double backoffMultiplier = 2.0;
+    /// @brief Waits a uniformly random time between zero and the computed backoff ("full jitter"),
+    /// so clients failing together do not retry together. Defaults to true.
+    bool jitter = true;
+    /// @brief Also retries POST requests, which are not idempotent. Defaults to false.
+    /// Requests streaming from an HttpBodySource or HttpFormStream are never retried, as their body cannot be replayed.
+    bool retryNonIdempotent = false;
+    /// @brief Response status codes that are retried. Defaults to 429, 502, 503 and 504.
+    std::vector<long> retryStatusCodes{429L, 502L, 503L, 504L};
+    /// @brief Every request earns this fraction of a retry and every retry spends one, so retries
+    /// cannot multiply the load on a struggling server by more than (1 + ratio). Defaults to 0.1.
+    double budgetRatio = 0.1;
+    /// @brief The most retries the budget can save up, which is also the budget at start. Defaults to 10.
+    double budgetBurst = 10.0;
+};
+
+/**
+ * @struct HttpHedgingPolicy
+ * @brief Sends a second copy of a slow GET request and keeps whichever response arrives first.
+ *
+ * Applies to blocking get calls that buffer the response body. The hedge is sent once the first attempt
+ * has been running longer than the configured percentile of recent GET latencies, so only the slowest
+ * requests are duplicated; the losing transfer is cancelled. Hedges are paid for from the retry budget
+ * (see HttpRetryPolicy::budgetRatio). With HttpHostLimits set, every hedge takes a host slot of its own
+ * and is skipped, without queueing, when none is free.
+ */
+struct HttpHedgingPolicy {
+    /// @brief Enables hedged GET requests. Defaults to false.
+    bool enabled = false;
+    /// @brief A fixed hedge delay. Defaults to unset, which derives the delay from recent latencies.
+    std::optional<std::chrono::milliseconds> delay;
+    /// @brief The latency percentile used as hedge delay. Defaults to 0.95.
+    double percentile = 0.95;
+    /// @brief The shortest derived hedge delay. Defaults to 10ms.
+    std::chrono::milliseconds minDelay{10};
+    /// @brief The number of extra copies a request may send, each after another hedge delay. Defaults to 1.
+    int maxHedges = 1;
+};
+
+/**
+ * @struct HttpHostLimits
+ * @brief Caps the blocking requests a client sends to one host at the same time.
+ *
+ * Requests beyond maxConcurrent wait in a per-host queue, and requests that find the queue full, or
+ * wait longer than maxQueueWait, fail at once with HttpOverloadedException (HttpErrorPhase::Overloaded
+ * from tryGet and tryPost) instead of piling onto a slow server. With adaptive set, the limit itself moves between adaptiveMinLimit and maxConcurrent:
+ * it grows by one for every limit's worth of healthy responses and shrinks by decreaseFactor (at most
+ * once per round trip) on timeouts, connection errors, 429 and 503 responses, or when recent latency
+ * rises above latencyTolerance times its long-term average. Limits apply per attempt to the blocking
+ * get and post calls, keyed by the host and port of the request URL.
+ */
+struct HttpHostLimits {
+    /// @brief Maximum concurrent requests per host, and the ceiling of the adaptive limit. Defaults to 0 (unlimited).
+    std::size_t maxConcurrent = 0;
+    /// @brief Maximum requests per host waiting for a free slot. Defaults to 0 (reject as soon as the limit is reached).
+    std::size_t maxQueued = 0;
+    /// @brief The longest a request waits for a free slot. Defaults to 1000ms.
+    std::chrono::milliseconds maxQueueWait{1000};
+    /// @brief Adjusts the limit to the observed latency and failures (AIMD). Requires maxConcurrent. Defaults to false.
+    bool adaptive = false;
+    /// @brief The lowest adaptive limit. Defaults to 1.
+    std::size_t adaptiveMinLimit = 1;
+    /// @brief How far recent latency may rise above the long-term average before the limit shrinks. Defaults to 2.
+    double latencyTolerance = 2.0;
+    /// @brief The factor the adaptive limit is multiplied by when the host is overloaded. Defaults to 0.9.
+    double decreaseFactor = 0.9;
+};
+
+/**
+ * @struct HttpCircuitBreakerPolicy
+ * @brief Stops sending blocking requests to a host that keeps failing.
+ *
+ * Every attempt of a blocking get or post counts as a failure if it ends with a transient transport
+ * error (the connection could not be opened, timed out or was dropped) or a 5xx response. Once at least
+ * minimumRequests attempts were seen within the rolling window and the share of failures reaches
+ * failureRateThreshold, the breaker opens: requests to the host fail at once with
+ * HttpCircuitOpenException (HttpErrorPhase::CircuitOpen from tryGet and tryPost), without a transfer. After openDuration it lets halfOpenProbes requests
+ * through; if they all succeed it closes again, and any failure reopens it.
+ */
+struct HttpCircuitBreakerPolicy {
+    /// @brief Enables a circuit breaker per host and port. Defaults to false.
+    bool enabled = false;
+    /// @brief The share of failed attempts, between 0 and 1, that opens the breaker. Defaults to 0.5.
+    double failureRateThreshold = 0.5;
+    /// @brief The fewest attempts within the window before the failure rate is trusted. Defaults to 20.
+    std::size_t minimumRequests = 20;
+    /// @brief The rolling window the failure rate is measured over. Defaults to 10000ms.
+    std::chrono::milliseconds window{10000};
+    /// @brief How long the breaker stays open before probing the host again. Defaults to 5000ms.
+    std::chrono::milliseconds openDuration{5000};
+    /// @brief The number of probe requests, sent one at a time, that must succeed to close the breaker. Defaults to 1.
+    std::size_t halfOpenProbes = 1;
+};
+
+/**
+ * @struct HttpSchedulerPolicy
+ * @brief How the client's event loops order and start asynchronous requests.
+ *
+ * Applies to the getAsync, postAsync, coGet and coPost calls and to HttpClient::warmup and
+ * HttpClient::download. Once maxInFlight transfers are running, further requests wait in one queue per
+ * HttpPriority, and free slots go to the waiting classes in proportion to their weights, so bulk
+ * transfers still progress but cannot starve critical ones. A request that is still waiting when the
+ * queue deadline of its class passes fails with CURLE_OPERATION_TIMEDOUT without being sent.
+ */
+struct HttpSchedulerPolicy {
+    /// @brief The most asynchronous transfers running at once, split evenly between the loop threads.
+    /// Defaults to 0 (unlimited: requests start as soon as their loop sees them).
+    std::size_t maxInFlight = 0;
+    /// @brief The relative share of slots for Critical, Normal and Bulk requests while all are waiting.
+    /// Every weight must be at least 1. Defaults to 8, 4 and 1.
+    std::array<unsigned, 3> weights{8U, 4U, 1U};
+    /// @brief The longest Critical, Normal and Bulk requests may wait for a slot; zero means no deadline.
+    /// Defaults to no deadlines.
+    std::array<std::chrono::milliseconds, 3> queueDeadlines{};
+    /// @brief The number of event-loop threads, each with its own multi handle; requests are spread
+    /// round-robin between them and connections are only reused within a loop. Defaults to 1.
+    std::size_t loopThreads = 1;
+    /// @brief Pins event-loop thread i to CPU core i (modulo the core count). Linux only. Defaults to false.
+    bool pinLoopThreads = false;
 };
 
 /**
@@ -48,12 +660,182 @@ struct HttpClientConfig {
     long connectTimeoutMs = 10000L;
     /// @brief Total request/read timeout in milliseconds. Defaults to 30000ms.
     long requestTimeoutMs = 30000L;
-    /// @brief Optional path to the client SSL certificate file.
+    /// @brief Optional path to the client SSL certificate file (PEM).
+    /// The file is read once when the client is constructed and handed to every request from memory.
     std::optional<std::string> clientCertPath;
-    /// @brief Optional path to the client SSL private key file.
+    /// @brief Optional path to the client SSL private key file (PEM), read once like clientCertPath.
     std::optional<std::string> clientKeyPath;
     /// @brief Optional password for the client SSL private key.
     std::optional<std::string> clientKeyPassword;
+    /// @brief Optional path to a PEM bundle of trusted certificate authorities, used instead of the system store.
+    /// The file is read once when the client is constructed. Defaults to unset.
+    std::optional<std::string> caCertPath;
+    /// @brief The oldest TLS version accepted. Defaults to TLS 1.2.
+    HttpTlsVersion tlsMinVersion = HttpTlsVersion::Tls1_2;
+    /// @brief The newest TLS version offered. Defaults to unset, which offers the newest version the TLS library supports (TLS 1.3 with OpenSSL).
+    std::optional<HttpTlsVersion> tlsMaxVersion;
+    /// @brief Cipher list for TLS 1.2 connections, in OpenSSL syntax (e.g., "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256").
+    /// Defaults to unset, which keeps the TLS library's list.
+    std::optional<std::string> tlsCipherList;
+    /// @brief TLS 1.3 cipher suites in order of preference (e.g., "TLS_AES_128_GCM_SHA256:TLS_CHACHA20_POLY1305_SHA256").
+    /// Defaults to unset, which keeps the TLS library's suites.
+    std::optional<std::string> tls13CipherSuites;
+    /// @brief Negotiates the HTTP version with ALPN during the TLS handshake. HTTP/2 over TLS needs it. Defaults to true.
+    bool tlsAlpn = true;
+    /// @brief Sends bodyless GET requests as TLS 1.3 early data (0-RTT) when a session is resumed. Early data can be
+    /// replayed by an attacker, so it is never used for requests with a body. Requires libcurl 8.11 or newer; ignored
+    /// by older builds. Defaults to false.
+    bool tlsEarlyData = false;
+    /// @brief Headers sent with every request. Per-call headers with the same name (ignoring case) take precedence.
+    std::map<std::string, std::string, std::less<>> defaultHeaders;
+    /// @brief Encodings offered in Accept-Encoding (e.g., "gzip", "br", "zstd" or "gzip, zstd"); responses are decoded transparently.
+    /// An empty string offers every encoding the linked libcurl can decode. Defaults to unset, which sends no Accept-Encoding.
+    std::optional<std::string> acceptEncoding;
+    /// @brief Gzip-compresses raw POST bodies of at least this many bytes and sends them with "Content-Encoding: gzip".
+    /// Bodies that would not shrink, or that already carry a Content-Encoding header, are sent as-is.
+    /// Defaults to 0 (disabled). Requires a build with zlib (HTTPCLIENT_WITH_ZLIB).
+    std::size_t compressRequestsAbove = 0;
+    /// @brief Maximum accepted size of a response body in bytes. Defaults to 0 (unlimited).
+    /// Larger responses fail with CurlException, and the body buffer is never pre-sized beyond this limit.
+    std::size_t maxBodyBytes = 0;
+    /// @brief Maximum number of idle CURL easy handles kept for reuse. Defaults to 8.
+    /// Reused handles keep their connection, DNS and TLS session caches warm. Set to 0 to disable pooling.
+    std::size_t handlePoolSize = 8;
+    /// @brief Sends "Expect: 100-continue" where libcurl would (HTTP/1.1 bodies over 1 MiB, chunked and multipart
+    /// bodies) and holds the body back until the server answers or expectContinueTimeoutMs passes. Servers that
+    /// ignore the header stall every such upload for the full timeout, so it is off by default.
+    bool expectContinue = false;
+    /// @brief How long an upload waits for "100 Continue" before sending the body anyway. Defaults to 1000ms.
+    long expectContinueTimeoutMs = 1000L;
+    /// @brief Shares the DNS cache between all threads using this client. Defaults to true.
+    bool shareDnsCache = true;
+    /// @brief Shares TLS session IDs between all threads so new connections can resume sessions
+    /// (and, with tlsEarlyData, send 0-RTT data). Defaults to true.
+    bool shareTlsSessions = true;
+    /// @brief Shares the connection cache between all threads so callers reuse each other's open sockets. Defaults to false.
+    /// libcurl does not support a shared connection cache used by handles running concurrently in different threads,
+    /// so this only suits clients whose blocking calls do not overlap. Clients called from many threads at once should
+    /// leave it off and rely on handlePoolSize, as every pooled handle keeps its own connections open.
+    bool shareConnections = false;
+    /// @brief Maximum number of idle connections kept in the shared connection cache. Defaults to 64.
+    long sharedConnectionCacheSize = 64L;
+    /// @brief Static name resolution pins in CURLOPT_RESOLVE form, "host:port:address[,address...]"
+    /// (e.g., "api.example.com:443:10.0.0.7"). Pinned names never go to DNS. Defaults to none.
+    std::vector<std::string> resolve;
+    /// @brief How long resolved names stay in the DNS cache, in seconds; -1 keeps them forever. Defaults to 60.
+    long dnsCacheTtlSeconds = 60L;
+    /// @brief Disables Nagle's algorithm, so small requests are sent without delay. Defaults to true.
+    bool tcpNoDelay = true;
+    /// @brief Sends TCP keep-alive probes on idle connections, so dead peers are noticed and NAT entries stay open. Defaults to false.
+    bool tcpKeepAlive = false;
+    /// @brief Idle time before the first keep-alive probe, in seconds. Defaults to 60.
+    long tcpKeepIdleSeconds = 60L;
+    /// @brief Interval between keep-alive probes, in seconds. Defaults to 60.
+    long tcpKeepIntervalSeconds = 60L;
+    /// @brief Origins reached over a Unix domain socket, keyed by scheme and authority exactly as they appear
+    /// in request URLs (e.g., "http://sidecar" or "http://localhost:15001"). The URL still provides the Host
+    /// header and path, and "https" origins run TLS over the socket. Defaults to none.
+    std::map<std::string, HttpUnixSocket, std::less<>> unixSockets;
+    /// @brief Head start of the IPv6 connection attempt before IPv4 is tried in parallel ("happy eyeballs"), in milliseconds. Defaults to 200.
+    long happyEyeballsTimeoutMs = 200L;
+    /// @brief The HTTP protocol version to request. Defaults to HttpVersion::Default.
+    HttpVersion httpVersion = HttpVersion::Default;
+    /// @brief Multiplexes concurrent asynchronous and batch transfers to the same host over a single
+    /// HTTP/2 or HTTP/3 connection instead of opening one connection per transfer. Defaults to true.
+    bool multiplex = true;
+    /// @brief Maximum number of transfers HttpClient::batch runs at the same time. Defaults to 64.
+    std::size_t batchMaxConcurrency = 64;
+    /// @brief Maximum number of connections HttpClient::batch opens to a single host. Defaults to 0 (unlimited).
+    long batchMaxHostConnections = 0L;
+    /// @brief Records request counts, latency histograms, in-flight requests, connection reuse and errors,
+    /// readable through HttpClient::metrics. Defaults to false.
+    bool enableMetrics = false;
+    /// @brief Retries of failed blocking requests. Defaults to no retries.
+    HttpRetryPolicy retry;
+    /// @brief Hedging of slow blocking GET requests. Defaults to disabled.
+    HttpHedgingPolicy hedging;
+    /// @brief Per-host concurrency and queue limits of blocking requests. Defaults to unlimited.
+    HttpHostLimits hostLimits;
+    /// @brief Per-host circuit breaking of blocking requests. Defaults to disabled.
+    HttpCircuitBreakerPolicy circuitBreaker;
+    /// @brief Keeps up to this many bytes of 200 responses to blocking GET requests in memory, honouring
+    /// Cache-Control (max-age, no-cache, no-store), Age and Vary. Fresh entries are returned without a
+    /// transfer and with all-zero timings; stale entries carrying an ETag or Last-Modified are revalidated
+    /// with If-None-Match or If-Modified-Since, and a 304 answer returns the stored response. Successful
+    /// POST requests drop the cached responses of their URL. The budget is split evenly between 16 shards,
+    /// so a response taking more than a sixteenth of it (body, headers and about 256 bytes of bookkeeping)
+    /// is never cached; a 1 MiB budget, for example, keeps responses of up to roughly 64 KiB. Defaults to 0 (disabled).
+    std::size_t responseCacheBytes = 0;
+    /// @brief Makes the buffered get calls coalesce like HttpClient::getShared, each caller receiving a copy
+    /// of the shared response. Defaults to false.
+    bool coalesceGets = false;
+    /// @brief Priority classes, in-flight limit and loop threads of asynchronous requests. Defaults to one
+    /// loop thread starting every request at once.
+    HttpSchedulerPolicy scheduler;
+};
+
+/**
+ * @struct HttpLatencyHistogram
+ * @brief A log-linear latency histogram in microseconds.
+ *
+ * Each power of two is split into 8 equal buckets, so any recorded value is known to within 12.5%.
+ * Latencies above 2^32 microseconds (about 71 minutes) are counted in the last bucket.
+ */
+struct HttpLatencyHistogram {
+    /// @brief The number of recorded requests.
+    std::uint64_t count = 0;
+    /// @brief The sum of all recorded latencies.
+    std::chrono::microseconds sum{0};
+    /// @brief The number of requests per bucket; bucket i covers latencies up to bucketUpperBound(i).
+    std::vector<std::uint64_t> buckets;
+
+    /**
+     * @brief Estimates a latency percentile.
+     * @param quantile The quantile between 0 and 1 (e.g., 0.99 for p99).
+     * @return The upper bound of the bucket holding the quantile, or zero if nothing was recorded.
+     */
+    [[nodiscard]] std::chrono::microseconds percentile(double quantile) const;
+
+    /// @brief Returns the largest latency counted in the given bucket.
+    [[nodiscard]] static std::chrono::microseconds bucketUpperBound(std::size_t index);
+};
+
+/**
+ * @struct HttpHostMetrics
+ * @brief Latency histograms of the requests sent to one host.
+ */
+struct HttpHostMetrics {
+    /// @brief The host and optional port the requests ended up at (after redirects).
+    std::string host;
+    /// @brief Histograms keyed by status class: 1 to 5 for 1xx to 5xx, and 0 for transfers that failed without a response.
+    std::map<int, HttpLatencyHistogram> byStatusClass;
+};
+
+/**
+ * @struct HttpMetricsSnapshot
+ * @brief A point-in-time copy of a client's metrics, see HttpClientConfig::enableMetrics.
+ */
+struct HttpMetricsSnapshot {
+    /// @brief Requests started but not yet finished.
+    std::int64_t inFlight = 0;
+    /// @brief Finished requests that went over an already open connection.
+    std::uint64_t reusedConnections = 0;
+    /// @brief Finished requests that had to open at least one new connection.
+    std::uint64_t newConnections = 0;
+    /// @brief Failed transfers keyed by CURLcode.
+    std::map<int, std::uint64_t> errorsByCode;
+    /// @brief Per-host latency histograms, ordered by host.
+    std::vector<HttpHostMetrics> hosts;
+
+    /// @brief The share of finished requests that reused a connection, between 0 and 1.
+    [[nodiscard]] double connectionReuseRatio() const noexcept;
+
+    /**
+     * @brief Serializes the snapshot in the Prometheus text exposition format.
+     * @param prefix The prefix of every metric name.
+     * @return The metrics text, ready to be served from a /metrics endpoint.
+     */
+    [[nodiscard]] std::string toPrometheus(std::string_view prefix = "httpclient") const;
 };
 
 /**
@@ -67,6 +849,34 @@ struct HttpFormFile {
     std::optional<std::string> contentType;
 };
 
+/**
+ * @struct HttpFormBuffer
+ * @brief Sends a part straight from caller-owned memory, without copying it.
+ *
+ * The memory must stay valid until the request completes.
+ */
+struct HttpFormBuffer {
+    /// @brief The bytes of the part.
+    std::span<const std::byte> data;
+    /// @brief The optional file name reported to the server, which then treats the part as a file upload.
+    std::optional<std::string> fileName;
+    /// @brief The optional MIME type of the part (e.g., "image/png").
+    std::optional<std::string> contentType;
+};
+
+/**
+ * @struct HttpFormStream
+ * @brief Generates a part chunk by chunk while it is uploaded, so it never has to be staged in memory or on disk.
+ */
+struct HttpFormStream {
+    /// @brief Produces the bytes of the part. Without a contentLength the request is sent chunked.
+    HttpBodySource source;
+    /// @brief The optional file name reported to the server, which then treats the part as a file upload.
+    std::optional<std::string> fileName;
+    /// @brief The optional MIME type of the part (e.g., "image/png").
+    std::optional<std::string> contentType;
+};
+
 /**
  * @struct HttpFormPart
  * @brief Represents a single part of a multipart/form-data request.
@@ -74,10 +884,35 @@ struct HttpFormFile {
 struct HttpFormPart {
     /// @brief The name of the form field.
     std::string name;
-    /// @brief The content of the part, which can be a simple string value or a file.
-    std::variant<std::string, HttpFormFile> contents;
+    /// @brief The content of the part: a string value, a file, a caller-owned buffer or a generator.
+    std::variant<std::string, HttpFormFile, HttpFormBuffer, HttpFormStream> contents;
+};
+
+/**
+ * @enum HttpMethod
+ * @brief The HTTP methods supported by HttpRequest.
+ */
+enum class HttpMethod {
+    Get,
+    Post
 };
 
+/**
+ * @struct HttpRequest
+ * @brief Describes a single request for HttpClient::batch.
+ */
+struct HttpRequest {
+    /// @brief The HTTP method. Defaults to GET.
+    HttpMethod method = HttpMethod::Get;
+    /// @brief The target URL.
+    std::string url;
+    /// @brief A map of request headers to be sent.
+    std::map<std::string, std::string, std::less<>> headers;
+    /// @brief The raw request body, used for POST requests without form parts.
+    std::string body;
+    /// @brief Multipart form fields and files. If not empty, a POST request is sent as multipart/form-data.
+    std::vector<HttpFormPart> formParts;
+};
 
 /**
  * @class HttpClient
@@ -111,15 +946,213 @@ public:
     [[nodiscard]] HttpResponse get(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
 
     /**
-     * @brief Performs an HTTP POST request with a raw string body.
+     * @brief Performs an HTTP GET request with a prepared header list.
+     * @param url The target URL for the GET request.
+     * @param headers The prepared headers, sent as-is.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure.
+     */
+    [[nodiscard]] HttpResponse get(const std::string& url, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP GET request without throwing on failure.
+     *
+     * Failed requests, including those rejected by the host limits or an open circuit breaker, are
+     * returned as an HttpError instead of being thrown, which keeps error-heavy retry loops cheap.
+     * get is a thin wrapper around this call.
+     * @param url The target URL for the GET request.
+     * @param headers A map of request headers to be sent.
+     * @return The HttpResponse, or the HttpError describing the failure.
+     */
+    [[nodiscard]] std::expected<HttpResponse, HttpError> tryGet(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP GET request with a prepared header list without throwing on failure, see tryGet.
+     * @param url The target URL for the GET request.
+     * @param headers The prepared headers, sent as-is.
+     * @return The HttpResponse, or the HttpError describing the failure.
+     */
+    [[nodiscard]] std::expected<HttpResponse, HttpError> tryGet(const std::string& url, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP GET request, sharing one transfer between identical concurrent calls.
+     *
+     * Calls with the same URL and request headers that arrive while a transfer for them is running wait
+     * for it instead of starting their own, and all receive the same immutable response without a copy.
+     * @param url The target URL for the GET request.
+     * @param headers A map of request headers to be sent.
+     * @return The shared response.
+     * @throws CurlException on failure; every waiting caller receives the same exception.
+     */
+    [[nodiscard]] std::shared_ptr<const HttpResponse> getShared(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs a coalesced HTTP GET request with a prepared header list, see getShared.
+     * @param url The target URL for the GET request.
+     * @param headers The prepared headers, sent as-is.
+     * @return The shared response.
+     * @throws CurlException on failure; every waiting caller receives the same exception.
+     */
+    [[nodiscard]] std::shared_ptr<const HttpResponse> getShared(const std::string& url, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP GET request into an existing response, reusing its body and header storage.
+     *
+     * The previous contents of the response are discarded, but the capacity of its buffers is kept, so
+     * a loop making similar requests stops allocating once the buffers have grown. Responses served from
+     * the response cache or shared by coalescing are copied in instead.
+     * @param url The target URL for the GET request.
+     * @param response The response to overwrite.
+     * @param headers A map of request headers to be sent.
+     * @throws CurlException on failure. The response keeps its buffers but its contents are unspecified.
+     */
+    void getInto(const std::string& url, HttpResponse& response, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP GET request with a prepared header list into an existing response, see getInto.
+     * @param url The target URL for the GET request.
+     * @param response The response to overwrite.
+     * @param headers The prepared headers, sent as-is.
+     * @throws CurlException on failure. The response keeps its buffers but its contents are unspecified.
+     */
+    void getInto(const std::string& url, HttpResponse& response, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP GET request, streaming the response body into a sink instead of buffering it.
+     * @param url The target URL for the GET request.
+     * @param sink Called with each body chunk as it arrives; returning false aborts the transfer.
+     * @param headers A map of request headers to be sent.
+     * @return An HttpResponse with the status code and headers; its body is left empty.
+     * @throws CurlException on failure or if the sink aborts the transfer. Exceptions thrown by the sink are propagated.
+     */
+    [[nodiscard]] HttpResponse get(const std::string& url, const HttpBodySink& sink, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP GET request, writing the response body straight to a file descriptor.
+     * @param url The target URL for the GET request.
+     * @param sink The file descriptor to write the body to.
+     * @param headers A map of request headers to be sent.
+     * @return An HttpResponse with the status code and headers; its body is left empty.
+     * @throws CurlException on failure, including write errors on the descriptor.
+     */
+    [[nodiscard]] HttpResponse get(const std::string& url, HttpFileDescriptorSink sink, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Downloads a large object to a file, fetching byte ranges of it in parallel.
+     *
+     * Sends a HEAD request for the size and validator (ETag or Last-Modified) of the object, preallocates
+     * the file and fetches up to HttpDownloadOptions::segments ranges at once on the client's event loop,
+     * each written straight to its place in the file. Progress is kept in "<path>.download" while the
+     * download runs; if it fails, calling download again with the same URL and path fetches only the
+     * missing bytes, as long as the object is unchanged. If a range request shows that the object changed
+     * on the server, the download fails at once and the progress is discarded. Servers that do not
+     * support ranges are sent a single GET. Over HTTP/2 with HttpClientConfig::multiplex set, the ranges share one connection.
+     * @param url The URL of the object.
+     * @param path The file to write. It is created if needed and overwritten.
+     * @param options How the object is split and retried.
+     * @return The size of the file and how much was resumed.
+     * @throws CurlException on failure, after saving the progress of the ranges fetched so far.
+     */
+    [[nodiscard]] HttpDownloadResult download(const std::string& url, const std::string& path, const HttpDownloadOptions& options = {}) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw body.
      * @param url The target URL for the POST request.
-     * @param body The data to be sent in the request body.
+     * @param body The data to be sent in the request body. It is sent straight from the caller's memory without being copied.
      * @param headers A map of request headers. A "Content-Type" header is recommended.
      * @return An HttpResponse struct containing the server's response.
      * @throws CurlException on failure.
      */
-    [[nodiscard]] HttpResponse post(const std::string& url, const std::string& body, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+    [[nodiscard]] HttpResponse post(const std::string& url, std::string_view body, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
     
+    /**
+     * @brief Performs an HTTP POST request with a raw body and a prepared header list.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body. It is sent straight from the caller's memory without being copied.
+     * @param headers The prepared headers, sent as-is.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, std::string_view body, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw body without throwing on failure, see tryGet.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body. It is sent straight from the caller's memory without being copied.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @return The HttpResponse, or the HttpError describing the failure.
+     */
+    [[nodiscard]] std::expected<HttpResponse, HttpError> tryPost(const std::string& url, std::string_view body, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw body and a prepared header list without throwing on failure, see tryGet.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body. It is sent straight from the caller's memory without being copied.
+     * @param headers The prepared headers, sent as-is.
+     * @return The HttpResponse, or the HttpError describing the failure.
+     */
+    [[nodiscard]] std::expected<HttpResponse, HttpError> tryPost(const std::string& url, std::string_view body, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw body into an existing response, see getInto.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body, sent straight from the caller's memory.
+     * @param response The response to overwrite.
+     * @param headers A map of request headers.
+     * @throws CurlException on failure. The response keeps its buffers but its contents are unspecified.
+     */
+    void postInto(const std::string& url, std::string_view body, HttpResponse& response, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw body and a prepared header list into an existing response, see getInto.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body, sent straight from the caller's memory.
+     * @param response The response to overwrite.
+     * @param headers The prepared headers, sent as-is.
+     * @throws CurlException on failure. The response keeps its buffers but its contents are unspecified.
+     */
+    void postInto(const std::string& url, std::string_view body, HttpResponse& response, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a binary body, such as a std::vector<std::byte> or a mapped file.
+     * @param url The target URL for the POST request.
+     * @param body The bytes to be sent in the request body. They are sent straight from the caller's memory without being copied.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, std::span<const std::byte> body, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a binary body and a prepared header list.
+     * @param url The target URL for the POST request.
+     * @param body The bytes to be sent in the request body. They are sent straight from the caller's memory without being copied.
+     * @param headers The prepared headers, sent as-is.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, std::span<const std::byte> body, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Performs an HTTP POST request whose body is pulled from a source while it is uploaded.
+     * @param url The target URL for the POST request.
+     * @param source Produces the body chunk by chunk. Redirects that would resend the body fail, since it cannot be rewound.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure, or the exception thrown by the source.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, const HttpBodySource& source, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs an HTTP POST request whose body is pulled from a source, with a prepared header list.
+     * @param url The target URL for the POST request.
+     * @param source Produces the body chunk by chunk. Redirects that would resend the body fail, since it cannot be rewound.
+     * @param headers The prepared headers, sent as-is.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure, or the exception thrown by the source.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, const HttpBodySource& source, const PreparedHeaders& headers) const;
+
     /**
      * @brief Performs a multipart/form-data HTTP POST request.
      * @param url The target URL for the POST request.
@@ -130,6 +1163,167 @@ public:
      */
     [[nodiscard]] HttpResponse post(const std::string& url, const std::vector<HttpFormPart>& formParts, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
 
+    /**
+     * @brief Performs a multipart/form-data HTTP POST request with a prepared header list.
+     * @param url The target URL for the POST request.
+     * @param formParts A vector of HttpFormPart objects representing the form fields and files.
+     * @param headers The prepared headers, sent as-is. "Content-Type" is handled automatically.
+     * @return An HttpResponse struct containing the server's response.
+     * @throws CurlException on failure.
+     */
+    [[nodiscard]] HttpResponse post(const std::string& url, const std::vector<HttpFormPart>& formParts, const PreparedHeaders& headers) const;
+
+    /**
+     * @brief Prepares a reusable header list that combines the client's default headers with the given ones.
+     * @param headers The per-call headers; they take precedence over default headers with the same name.
+     * @return A PreparedHeaders object for use with the get/post overloads that accept one.
+     * @throws CurlException if the list cannot be allocated.
+     */
+    [[nodiscard]] PreparedHeaders prepareHeaders(const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Performs a set of requests concurrently on the calling thread.
+     *
+     * All transfers are driven through a single curl multi handle, limited by
+     * HttpClientConfig::batchMaxConcurrency and HttpClientConfig::batchMaxHostConnections.
+     * A failing request does not affect the others.
+     * @param requests The requests to perform.
+     * @return One result per request, in the same order as the input.
+     */
+    [[nodiscard]] std::vector<std::expected<HttpResponse, CurlError>> batch(std::span<const HttpRequest> requests) const;
+
+    /**
+     * @brief Resolves and connects to a set of origins ahead of the first real requests.
+     *
+     * Sends a HEAD request for every origin on the client's event loop, so name resolution, the TCP
+     * and TLS handshakes and HTTP/2 negotiation are done before traffic arrives. Any response counts as
+     * success. The resolved names and TLS sessions are shared with blocking calls (see shareDnsCache and
+     * shareTlsSessions). With shareConnections the opened keep-alive connections are reused by blocking
+     * calls as well; otherwise up to connectionsPerOrigin pooled handles (at most handlePoolSize) are
+     * also warmed with blocking HEAD requests, so the first blocking calls find open connections too.
+     * @param origins Origins such as "https://api.example.com" or "http://10.0.0.5:8080"; a path may be included.
+     * @param connectionsPerOrigin The number of parallel requests sent to each origin. HTTP/1.1 opens one
+     *        connection per request, while HTTP/2 origins multiplex them onto one connection.
+     * @return One result per origin, in the same order as the input, holding the first failure if any.
+     */
+    [[nodiscard]] std::vector<std::expected<void, CurlError>> warmup(std::span<const std::string> origins, std::size_t connectionsPerOrigin = 1) const;
+
+    /**
+     * @brief Starts an HTTP GET request on the client's event-loop thread.
+     * @param url The target URL for the GET request.
+     * @param headers A map of request headers to be sent.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return A future that yields the HttpResponse, or throws CurlException on failure.
+     */
+    [[nodiscard]] std::future<HttpResponse> getAsync(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts an HTTP GET request and reports the result through a callback.
+     * @param url The target URL for the GET request.
+     * @param onComplete Called once with the response or the error.
+     * @param headers A map of request headers to be sent.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     */
+    void getAsync(const std::string& url, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts an HTTP POST request with a raw string body on the client's event-loop thread.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body. It is kept alive until the transfer finishes.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return A future that yields the HttpResponse, or throws CurlException on failure.
+     */
+    [[nodiscard]] std::future<HttpResponse> postAsync(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts an HTTP POST request with a raw string body and reports the result through a callback.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body. It is kept alive until the transfer finishes.
+     * @param onComplete Called once with the response or the error.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     */
+    void postAsync(const std::string& url, std::string body, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts an HTTP POST request whose body is written into an upload stream while it is sent.
+     * @param url The target URL for the POST request.
+     * @param body The stream the body is written into, from any thread, once the request has started.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return A future that yields the HttpResponse, or throws CurlException on failure or if the stream was aborted.
+     */
+    [[nodiscard]] std::future<HttpResponse> postAsync(const std::string& url, HttpUploadStream& body, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts an HTTP POST request from an upload stream and reports the result through a callback.
+     * @param url The target URL for the POST request.
+     * @param body The stream the body is written into, from any thread, once the request has started.
+     * @param onComplete Called once with the response or the error.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     */
+    void postAsync(const std::string& url, HttpUploadStream& body, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts a multipart/form-data HTTP POST request on the client's event-loop thread.
+     * @param url The target URL for the POST request.
+     * @param formParts A vector of HttpFormPart objects representing the form fields and files.
+     * @param headers A map of request headers. "Content-Type" is handled automatically.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return A future that yields the HttpResponse, or throws CurlException on failure.
+     */
+    [[nodiscard]] std::future<HttpResponse> postAsync(const std::string& url, const std::vector<HttpFormPart>& formParts, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Starts a multipart/form-data HTTP POST request and reports the result through a callback.
+     * @param url The target URL for the POST request.
+     * @param formParts A vector of HttpFormPart objects representing the form fields and files.
+     * @param onComplete Called once with the response or the error.
+     * @param headers A map of request headers. "Content-Type" is handled automatically.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     */
+    void postAsync(const std::string& url, const std::vector<HttpFormPart>& formParts, HttpCompletionHandler onComplete, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Performs an HTTP GET request from a coroutine: `HttpResponse r = co_await client.coGet(url);`
+     * @param url The target URL for the GET request.
+     * @param headers A map of request headers to be sent.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return An awaitable yielding the HttpResponse; the coroutine resumes on the client's event-loop thread.
+     * @throws CurlException from the co_await expression on failure.
+     */
+    [[nodiscard]] HttpAwaitable coGet(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Performs an HTTP POST request with a raw string body from a coroutine.
+     * @param url The target URL for the POST request.
+     * @param body The data to be sent in the request body.
+     * @param headers A map of request headers. A "Content-Type" header is recommended.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return An awaitable yielding the HttpResponse; the coroutine resumes on the client's event-loop thread.
+     * @throws CurlException from the co_await expression on failure.
+     */
+    [[nodiscard]] HttpAwaitable coPost(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Performs a multipart/form-data HTTP POST request from a coroutine.
+     * @param url The target URL for the POST request.
+     * @param formParts A vector of HttpFormPart objects representing the form fields and files.
+     * @param headers A map of request headers. "Content-Type" is handled automatically.
+     * @param priority The scheduling class of the request, see HttpSchedulerPolicy.
+     * @return An awaitable yielding the HttpResponse; the coroutine resumes on the client's event-loop thread.
+     * @throws CurlException from the co_await expression on failure.
+     */
+    [[nodiscard]] HttpAwaitable coPost(const std::string& url, std::vector<HttpFormPart> formParts, const std::map<std::string, std::string, std::less<>>& headers = {}, HttpPriority priority = HttpPriority::Normal) const;
+
+    /**
+     * @brief Takes a snapshot of the client's metrics.
+     * @return The metrics recorded so far; empty if HttpClientConfig::enableMetrics is false.
+     */
+    [[nodiscard]] HttpMetricsSnapshot metrics() const;
+
 private:
     /// @brief Forward declaration for the private implementation (PImpl idiom).
     class Impl;
@@ -18,6 +18,15 @@
 #include <format>     // For std::format
 #include <fstream>    // For file I/O in tests
 #include <cstdio>     // For std::remove
+#include <future>     // For std::future and std::promise
+#include <coroutine>  // For std::suspend_never
+#include <exception>  // For std::terminate
+#include <span>       // For std::span
+#include <cstring>    // For std::memcpy
+#include <cstddef>    // For std::byte
+#include <atomic>     // For std::atomic
+#include <algorithm>  // For std::ranges::count
+#include <mutex>      // For std::mutex
 
 /**
  * @brief Prints the contents of an HttpResponse to the console.
@@ -68,6 +77,163 @@ void test_get_with_headers() {
     }
 }
 
+/**
+ * @brief Tests case-insensitive response header lookup and the map compatibility view.
+ */
+void test_response_headers() {
+    try {
+        HttpClient client;
+        HttpResponse response = client.get("https://httpbin.org/response-headers?X-Test-Header=flat");
+        std::cout << "--- Response Headers ---\n";
+        assert(response.statusCode == 200);
+        assert(response.headers.get("x-test-header") == "flat");
+        assert(response.headers.at("X-TEST-HEADER") == "flat");
+        assert(response.headers.contains("content-type"));
+        assert(!response.headers.get("X-Not-Present"));
+        const auto& header_map = response.headers.asMap();
+        assert(header_map.size() <= response.headers.size());
+        assert(&response.headers.asMap() == &header_map);
+        std::cout << std::format("Found {} headers; X-Test-Header = {}\n\n", response.headers.size(), response.headers.at("x-test-header"));
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Response Headers' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests the per-request timing breakdown and connection reuse reporting.
+ */
+void test_response_timings() {
+    try {
+        HttpClient client;
+        const HttpResponse first = client.get("https://httpbin.org/get");
+        const HttpResponse second = client.get("https://httpbin.org/get");
+        assert(first.statusCode == 200 && second.statusCode == 200);
+
+        const HttpTimings& timings = first.timings;
+        std::cout << "--- Response Timings ---\n";
+        std::cout << std::format("DNS {}us, connect {}us, TLS {}us, TTFB {}us, total {}us, HTTP {}, {} bytes\n",
+                                 timings.nameLookup.count(), timings.connect.count(), timings.appConnect.count(),
+                                 timings.startTransfer.count(), timings.total.count(), timings.httpVersion, timings.bytesDownloaded);
+        assert(timings.connect >= timings.nameLookup);
+        assert(timings.appConnect >= timings.connect);
+        assert(timings.total >= timings.startTransfer);
+        assert(timings.bytesDownloaded == first.body.size());
+        assert(timings.httpVersion >= 11);
+        assert(!timings.connectionReused);
+        // The pooled handle keeps the connection open, so the second request skips connect and TLS.
+        assert(second.timings.connectionReused);
+        std::cout << std::format("Second request reused the connection: {}\n\n", second.timings.connectionReused);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Response Timings' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests the client-wide metrics registry and its Prometheus export.
+ */
+void test_metrics() {
+    try {
+        HttpClientConfig config;
+        config.enableMetrics = true;
+        HttpClient client(config);
+        for (int i = 0; i < 3; ++i) {
+            (void)client.get("https://httpbin.org/get");
+        }
+        (void)client.get("https://httpbin.org/status/404");
+
+        const HttpMetricsSnapshot snapshot = client.metrics();
+        std::cout << "--- Metrics ---\n" << snapshot.toPrometheus() << "\n";
+        assert(snapshot.inFlight == 0);
+        assert(snapshot.hosts.size() == 1 && snapshot.hosts[0].host == "httpbin.org");
+        const auto& by_class = snapshot.hosts[0].byStatusClass;
+        assert(by_class.at(2).count == 3);
+        assert(by_class.at(4).count == 1);
+        assert(by_class.at(2).percentile(0.99) >= by_class.at(2).percentile(0.5));
+        assert(snapshot.connectionReuseRatio() > 0.0);
+        assert(snapshot.toPrometheus().find("httpclient_request_duration_seconds_count{host=\"httpbin.org\",status_class=\"2xx\"} 3") != std::string::npos);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Metrics' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests fresh hits and ETag revalidation in the in-memory response cache.
+ */
+void test_response_cache() {
+    try {
+        HttpClientConfig config;
+        config.responseCacheBytes = 1024 * 1024;
+        HttpClient client(config);
+
+        // httpbin's /cache/{n} answers with "Cache-Control: public, max-age=n".
+        const HttpResponse first = client.get("https://httpbin.org/cache/60");
+        const HttpResponse cached = client.get("https://httpbin.org/cache/60");
+        std::cout << std::format("--- Response Cache ---\nFresh hit took {}us\n", cached.timings.total.count());
+        assert(cached.statusCode == 200 && cached.body == first.body);
+        assert(cached.timings.total.count() == 0);
+
+        // /etag/{etag} has no max-age, so the second call revalidates and the server's 304 counts as a hit.
+        const HttpResponse tagged = client.get("https://httpbin.org/etag/abc");
+        const HttpResponse revalidated = client.get("https://httpbin.org/etag/abc");
+        std::cout << std::format("Revalidated status: {}\n\n", revalidated.statusCode);
+        assert(revalidated.statusCode == 200 && revalidated.body == tagged.body);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Response Cache' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests default headers from the config and reusable prepared header lists.
+ */
+void test_prepared_headers() {
+    try {
+        HttpClientConfig config;
+        config.defaultHeaders = {{"X-Default-Header", "from-config"}, {"Accept", "text/plain"}};
+        HttpClient client(config);
+
+        // Per-call headers are merged with the defaults and override them by name.
+        HttpResponse response = client.get("https://httpbin.org/headers", {{"accept", "application/json"}});
+        assert(response.statusCode == 200);
+        assert(response.body.find("from-config") != std::string::npos);
+        assert(response.body.find("application/json") != std::string::npos);
+
+        const PreparedHeaders prepared = client.prepareHeaders({{"X-Prepared-Header", "reused"}});
+        for (int i = 0; i < 2; ++i) {
+            response = client.get("https://httpbin.org/headers", prepared);
+            assert(response.statusCode == 200);
+            assert(response.body.find("reused") != std::string::npos);
+            assert(response.body.find("from-config") != std::string::npos);
+        }
+        std::cout << "--- Prepared Headers ---\nDefault and prepared headers were sent.\n\n";
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Prepared Headers' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests getInto and postInto, which reuse the buffers of a caller-owned HttpResponse.
+ */
+void test_reused_response() {
+    try {
+        const HttpClient client;
+        HttpResponse response;
+        client.getInto("https://httpbin.org/bytes/4096", response);
+        assert(response.statusCode == 200 && response.body.size() == 4096);
+        const char* buffer = response.body.data();
+
+        // A smaller body fits the buffer the first call grew, so it is written in place.
+        client.getInto("https://httpbin.org/bytes/1024", response);
+        assert(response.statusCode == 200 && response.body.size() == 1024);
+        assert(response.body.data() == buffer);
+
+        client.postInto("https://httpbin.org/post", "reused=1", response, {{"Content-Type", "application/x-www-form-urlencoded"}});
+        assert(response.statusCode == 200 && response.body.find("reused") != std::string::npos);
+        std::cout << std::format("--- Reused Response ---\nBody capacity kept across calls: {} bytes\n\n", response.body.capacity());
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Reused Response' failed: {}\n", e.what());
+    }
+}
+
 /**
  * @brief Tests a simple HTTP POST request with a JSON body.
  */
@@ -89,6 +255,65 @@ void test_simple_post() {
     }
 }
 
+/**
+ * @brief Tests POST bodies sent from caller-owned bytes and from a pull-based body source.
+ */
+void test_zero_copy_post() {
+    try {
+        HttpClient client;
+        const std::string payload = R"({"zero": "copy"})";
+        std::vector<std::byte> bytes(payload.size());
+        std::memcpy(bytes.data(), payload.data(), payload.size());
+        HttpResponse response = client.post("https://httpbin.org/post", std::span<const std::byte>(bytes), {{"Content-Type", "application/json"}});
+        print_response("Zero-copy POST (bytes)", response);
+        assert(response.statusCode == 200);
+        assert(response.body.find("\"zero\": \"copy\"") != std::string::npos);
+
+        // Generates the body in small pieces while it is uploaded, so it never exists as a whole.
+        int remaining_chunks = 4;
+        HttpBodySource source{.read = [&remaining_chunks](std::span<char> buffer) -> std::size_t {
+                                  if (remaining_chunks == 0 || buffer.size() < 4) return 0;
+                                  --remaining_chunks;
+                                  std::memcpy(buffer.data(), "gen-", 4);
+                                  return 4;
+                              },
+                              .contentLength = 16};
+        response = client.post("https://httpbin.org/post", source, {{"Content-Type", "text/plain"}});
+        print_response("Zero-copy POST (source)", response);
+        assert(response.statusCode == 200);
+        assert(response.body.find("gen-gen-gen-gen-") != std::string::npos);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Zero-copy POST' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests transparent response decoding and gzip compression of large request bodies.
+ */
+void test_compression() {
+    try {
+        HttpClientConfig config;
+        config.acceptEncoding = "gzip";
+        config.compressRequestsAbove = 1024;
+        HttpClient client(config);
+
+        HttpResponse response = client.get("https://httpbin.org/gzip");
+        print_response("Compressed GET", response);
+        assert(response.statusCode == 200);
+        assert(response.body.find("\"gzipped\": true") != std::string::npos);
+
+        const std::string large_body(4096, 'z');
+        response = client.post("https://httpbin.org/post", large_body, {{"Content-Type", "text/plain"}});
+        std::cout << "--- Compressed POST ---\n";
+        assert(response.statusCode == 200);
+        // httpbin echoes the request headers without decoding the body
+        assert(response.body.find("\"Content-Encoding\": \"gzip\"") != std::string::npos);
+        std::cout << "Request body was sent gzip-compressed.\n\n";
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Compression' failed: {}\n", e.what());
+    }
+}
+
 /**
  * @brief Tests a multipart/form-data POST request with a field and a file.
  */
@@ -126,6 +351,124 @@ void test_multipart_post() {
     std::remove(temp_filename.c_str());
 }
 
+/**
+ * @brief Tests multipart parts sent from an in-memory buffer and from a generator, without a temporary file.
+ */
+void test_streaming_multipart_post() {
+    try {
+        HttpClient client;
+        const std::string image_bytes = "not-really-a-png";
+        int remaining_chunks = 3;
+        HttpBodySource generator{.read = [&remaining_chunks](std::span<char> buffer) -> std::size_t {
+                                     if (remaining_chunks == 0 || buffer.size() < 6) return 0;
+                                     --remaining_chunks;
+                                     std::memcpy(buffer.data(), "chunk.", 6);
+                                     return 6;
+                                 },
+                                 .contentLength = std::nullopt};
+        std::vector<HttpFormPart> parts = {
+            {"image", HttpFormBuffer{.data = std::as_bytes(std::span(image_bytes)), .fileName = "image.png", .contentType = "image/png"}},
+            {"generated", HttpFormStream{.source = generator, .fileName = "generated.txt", .contentType = "text/plain"}}
+        };
+
+        HttpResponse response = client.post("https://httpbin.org/post", parts);
+        print_response("Streaming multipart POST", response);
+
+        assert(response.statusCode == 200);
+        // Parts with a file name are reported in httpbin's 'files' object
+        assert(response.body.find("\"image\": \"not-really-a-png\"") != std::string::npos);
+        assert(response.body.find("\"generated\": \"chunk.chunk.chunk.\"") != std::string::npos);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Streaming multipart POST' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests streaming a response body into a sink, including aborting it early.
+ */
+void test_streaming_get() {
+    try {
+        HttpClient client;
+        const std::size_t expected_size = 100 * 1024;
+        std::size_t received = 0;
+        HttpResponse response = client.get(std::format("https://httpbin.org/bytes/{}", expected_size),
+                                           [&received](std::span<const char> chunk) {
+                                               received += chunk.size();
+                                               return true;
+                                           });
+        std::cout << "--- Streaming GET ---\n";
+        std::cout << std::format("Status Code: {}, streamed {} bytes\n", response.statusCode, received);
+        assert(response.statusCode == 200);
+        assert(received == expected_size);
+        assert(response.body.empty());
+
+        bool aborted = false;
+        try {
+            (void)client.get(std::format("https://httpbin.org/bytes/{}", expected_size),
+                             [](std::span<const char>) { return false; });
+        } catch (const CurlException& e) {
+            aborted = true;
+            std::cout << std::format("Sink abort reported: {}\n\n", e.what());
+        }
+        assert(aborted);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Streaming GET' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests buffering a large body and rejecting one that exceeds maxBodyBytes.
+ */
+void test_max_body_bytes() {
+    const std::size_t body_size = 64 * 1024;
+    try {
+        HttpClientConfig config;
+        config.maxBodyBytes = body_size;
+        HttpClient client(config);
+        HttpResponse response = client.get(std::format("https://httpbin.org/bytes/{}", body_size));
+        assert(response.statusCode == 200);
+        assert(response.body.size() == body_size);
+
+        bool rejected = false;
+        try {
+            (void)client.get(std::format("https://httpbin.org/bytes/{}", body_size + 1));
+        } catch (const CurlException& e) {
+            rejected = true;
+            std::cout << "--- Max Body Bytes ---\n";
+            std::cout << std::format("Oversized body rejected: {}\n\n", e.what());
+        }
+        assert(rejected);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Max Body Bytes' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests a segmented download, which fetches byte ranges of the object in parallel into one file.
+ */
+void test_segmented_download() {
+    const std::string filename = "test_download.bin";
+    try {
+        HttpClient client;
+        HttpDownloadOptions options;
+        options.segments = 4;
+        options.minSegmentBytes = 256;
+        // httpbin serves /range/N with Accept-Ranges and an ETag, so it is split into four 256-byte ranges.
+        const HttpDownloadResult result = client.download("https://httpbin.org/range/1024", filename, options);
+        assert(result.bytes == 1024);
+        assert(result.segments == 4);
+
+        std::ifstream file(filename, std::ios::binary);
+        const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        assert(contents.size() == 1024);
+        assert(contents.starts_with("abcdefghijklmnopqrstuvwxyz"));
+        std::cout << std::format("--- Segmented Download ---\nDownloaded {} bytes in {} ranges.\n\n", result.bytes, result.segments);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Segmented Download' failed: {}\n", e.what());
+    }
+    std::remove(filename.c_str());
+}
+
 /**
  * @brief Tests connection failure to a non-routable address.
  */
@@ -140,6 +483,54 @@ void test_connection_failure() {
     }
 }
 
+/**
+ * @brief Tests the non-throwing tryGet and tryPost calls and the phase reported for each kind of failure.
+ */
+void test_try_requests() {
+    std::cout << "--- Try Requests ---\n";
+    HttpClientConfig config;
+    config.connectTimeoutMs = 2000L;
+    config.requestTimeoutMs = 1000L;
+    const HttpClient client(config);
+
+    const auto ok = client.tryPost("https://httpbin.org/post", R"({"try": true})", {{"Content-Type", "application/json"}});
+    assert(ok && ok->statusCode == 200);
+
+    const auto dns = client.tryGet("https://no-such-host.invalid/");
+    assert(!dns && dns.error().phase == HttpErrorPhase::Dns);
+
+    const auto timeout = client.tryGet("https://httpbin.org/delay/3");
+    assert(!timeout && timeout.error().phase == HttpErrorPhase::Timeout);
+    // The timings show how far the failed attempt got: connected, but no response in time.
+    assert(timeout.error().timings.total >= timeout.error().timings.connect);
+    std::cout << std::format("DNS failure: {}\nTimeout after {}us: {}\n\n", dns.error().message,
+                             timeout.error().timings.total.count(), timeout.error().message);
+}
+
+/**
+ * @brief Tests routing a configured origin over a Unix domain socket while other origins keep using TCP.
+ */
+void test_unix_socket() {
+    std::cout << "--- Unix Socket ---\n";
+    HttpClientConfig config;
+    config.unixSockets = {{"http://sidecar", {.path = "/tmp/httpclient-test-missing.sock"}}};
+    HttpClient client(config);
+    try {
+        (void)client.get("http://sidecar/health");
+        std::cerr << "Test 'Unix Socket' failed: Expected the missing socket to refuse the connection.\n";
+    } catch (const CurlException& e) {
+        std::cout << std::format("Routed to the socket: {}\n", e.what());
+    }
+    try {
+        // Origins without a socket keep using TCP.
+        const HttpResponse response = client.get("https://httpbin.org/get");
+        std::cout << std::format("TCP origin status: {}\n\n", response.statusCode);
+        assert(response.statusCode == 200);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Unix Socket' failed: {}\n", e.what());
+    }
+}
+
 /**
  * @brief Tests the request timeout functionality.
  */
@@ -156,6 +547,79 @@ void test_timeout() {
     }
 }
 
+/**
+ * @brief Tests retries with backoff, giving up after repeated timeouts, and hedged GET requests.
+ */
+void test_retries() {
+    try {
+        HttpClientConfig config;
+        config.requestTimeoutMs = 1000L;
+        config.retry.maxAttempts = 3;
+        config.retry.initialBackoff = std::chrono::milliseconds(50);
+        HttpClient client(config);
+        const auto started = std::chrono::steady_clock::now();
+        HttpResponse response = client.get("https://httpbin.org/status/503");
+        std::cout << std::format("--- Retries ---\nStatus after {} attempts: {}\n", config.retry.maxAttempts, response.statusCode);
+        assert(response.statusCode == 503);
+
+        // Every attempt times out, so the call takes at least three timeouts before it gives up.
+        try {
+            (void)client.get("https://httpbin.org/delay/3");
+            std::cerr << "Test 'Retries' failed: Expected a timeout exception, but none was thrown.\n";
+        } catch (const CurlException& e) {
+            std::cout << std::format("Gave up after retrying: {}\n", e.what());
+            assert(std::chrono::steady_clock::now() - started >= std::chrono::seconds(3));
+        }
+
+        HttpClientConfig hedged_config;
+        hedged_config.hedging.enabled = true;
+        hedged_config.hedging.delay = std::chrono::milliseconds(500);
+        HttpClient hedged(hedged_config);
+        response = hedged.get("https://httpbin.org/get");
+        std::cout << std::format("Hedged GET status: {}\n", response.statusCode);
+        assert(response.statusCode == 200);
+
+        // With a single host slot, taken by the first copy, the hedge is skipped instead of cancelled.
+        hedged_config.hostLimits.maxConcurrent = 1;
+        hedged_config.enableMetrics = true;
+        HttpClient limited(hedged_config);
+        response = limited.get("https://httpbin.org/delay/1");
+        const HttpMetricsSnapshot metrics = limited.metrics();
+        std::cout << std::format("Slot-limited hedged GET status: {}, transfers: {}\n\n", response.statusCode,
+                                 metrics.newConnections + metrics.reusedConnections + metrics.errorsByCode.size());
+        assert(response.statusCode == 200 && metrics.errorsByCode.empty());
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Retries' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests that the circuit breaker opens after repeated server errors and rejects requests without sending them.
+ */
+void test_circuit_breaker() {
+    std::cout << "--- Circuit Breaker ---\n";
+    HttpClientConfig config;
+    config.circuitBreaker.enabled = true;
+    config.circuitBreaker.minimumRequests = 3;
+    HttpClient client(config);
+    for (int i = 0; i < 3; ++i) {
+        try {
+            const HttpResponse response = client.get("https://httpbin.org/status/500");
+            std::cout << std::format("Attempt {} returned status {}\n", i + 1, response.statusCode);
+        } catch (const CurlException& e) {
+            std::cerr << std::format("Test 'Circuit Breaker' failed: {}\n", e.what());
+        }
+    }
+    try {
+        (void)client.get("https://httpbin.org/get");
+        std::cerr << "Test 'Circuit Breaker' failed: Expected the breaker to be open.\n";
+    } catch (const HttpCircuitOpenException& e) {
+        std::cout << std::format("Failed fast: {}\n\n", e.what());
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Circuit Breaker' failed: {}\n", e.what());
+    }
+}
+
 /**
  * @brief Tests failure when connecting to a server with an invalid SSL certificate.
  */
@@ -170,6 +634,64 @@ void test_invalid_certificate() {
     }
 }
 
+/**
+ * @brief Tests the TLS version bounds, TLS 1.3 cipher suites and up-front loading of certificate files.
+ */
+void test_tls_settings() {
+    try {
+        HttpClientConfig config;
+        config.tlsMinVersion = HttpTlsVersion::Tls1_3;
+        config.tls13CipherSuites = "TLS_AES_128_GCM_SHA256:TLS_CHACHA20_POLY1305_SHA256";
+        HttpClient client(config);
+        for (int i = 0; i < 2; ++i) {
+            // The second request resumes the TLS session if the server closed the first connection.
+            HttpResponse response = client.get("https://httpbin.org/get");
+            assert(response.statusCode == 200);
+        }
+
+        // A TLS 1.3 floor refuses a server that only speaks TLS 1.2.
+        try {
+            (void)client.get("https://tls-v1-2.badssl.com:1012/");
+            std::cerr << "Test 'TLS Settings' failed: Expected an exception for a TLS 1.2 server.\n";
+            return;
+        } catch (const CurlException&) {
+            // Expected.
+        }
+
+        // Certificate files are read when the client is built, so a bad path fails here and not on first use.
+        HttpClientConfig missing;
+        missing.clientCertPath = "/nonexistent/client.pem";
+        try {
+            HttpClient unusable(missing);
+            std::cerr << "Test 'TLS Settings' failed: Expected an exception for a missing certificate file.\n";
+            return;
+        } catch (const CurlException& e) {
+            std::cout << std::format("--- TLS Settings ---\nTLS 1.3 requests succeeded; rejected: {}\n\n", e.what());
+        }
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'TLS Settings' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests that pooled handles are reset between requests on the same client.
+ */
+void test_handle_reuse() {
+    try {
+        HttpClient client;
+        (void)client.post("https://httpbin.org/post", std::string("warm-up"), {{"Content-Type", "text/plain"}});
+        // A stale POST configuration on the reused handle would make httpbin answer 405 here.
+        for (int i = 0; i < 3; ++i) {
+            HttpResponse response = client.get(std::format("https://httpbin.org/get?request={}", i));
+            assert(response.statusCode == 200);
+            assert(response.body.find(std::format("request={}", i)) != std::string::npos);
+        }
+        std::cout << "--- Handle Reuse ---\nSequential requests on a pooled handle succeeded.\n\n";
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Handle Reuse' failed: {}\n", e.what());
+    }
+}
+
 /**
  * @brief Tests the thread safety of the HttpClient class by making concurrent requests.
  */
@@ -200,6 +722,336 @@ void test_thread_safety() {
     std::cout << "Thread safety test completed.\n\n";
 }
 
+/**
+ * @brief Tests that requests beyond the per-host concurrency and queue limits are shed with HttpOverloadedException.
+ */
+void test_host_limits() {
+    std::cout << "--- Host Limits ---\n";
+
+    HttpClientConfig config;
+    config.hostLimits.maxConcurrent = 2;
+    config.hostLimits.maxQueued = 1;
+    config.hostLimits.maxQueueWait = std::chrono::milliseconds(200);
+    const HttpClient client(config);
+    std::atomic<int> completed{0};
+    std::atomic<int> rejected{0};
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < 5; ++i) {
+            threads.emplace_back([&client, &completed, &rejected]() {
+                try {
+                    (void)client.get("https://httpbin.org/delay/1");
+                    ++completed;
+                } catch (const HttpOverloadedException& e) {
+                    std::cout << std::format("Rejected: {}\n", e.what());
+                    ++rejected;
+                } catch (const CurlException& e) {
+                    std::cerr << std::format("Test 'Host Limits' failed: {}\n", e.what());
+                }
+            });
+        }
+    }
+    std::cout << std::format("{} completed, {} rejected.\n\n", completed.load(), rejected.load());
+    assert(completed == 2 && rejected == 3);
+}
+
+/**
+ * @brief Tests that identical concurrent getShared calls are coalesced into one transfer and share its response.
+ */
+void test_single_flight() {
+    std::cout << "--- Single Flight ---\n";
+    const HttpClient client;
+    std::vector<std::shared_ptr<const HttpResponse>> responses(8);
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t i = 0; i < responses.size(); ++i) {
+            threads.emplace_back([&client, &responses, i]() {
+                try {
+                    responses[i] = client.getShared("https://httpbin.org/delay/1");
+                } catch (const CurlException& e) {
+                    std::cerr << std::format("Test 'Single Flight' failed: {}\n", e.what());
+                }
+            });
+        }
+    }
+    const auto shared = std::ranges::count(responses, responses.front());
+    std::cout << std::format("{} of {} callers shared the first response.\n\n", shared, responses.size());
+    assert(responses.front() && responses.front()->statusCode == 200);
+    assert(static_cast<std::size_t>(shared) == responses.size());
+}
+
+/**
+ * @brief Tests warming up connections to a set of origins, with and without a shared connection cache.
+ */
+void test_warmup() {
+    try {
+        HttpClientConfig config;
+        config.shareConnections = true;
+        config.tcpKeepAlive = true;
+        config.connectTimeoutMs = 2000L;
+        HttpClient client(config);
+        const std::vector<std::string> origins = {"https://httpbin.org", "https://192.0.2.1"};
+        const auto results = client.warmup(origins);
+        std::cout << "--- Warmup ---\n";
+        for (std::size_t i = 0; i < origins.size(); ++i) {
+            std::cout << std::format("{}: {}\n", origins[i], results[i] ? "connected" : results[i].error().message);
+        }
+        assert(results[0] && !results[1]);
+
+        const HttpResponse response = client.get("https://httpbin.org/get");
+        std::cout << std::format("First request reused a warm connection: {}\n", response.timings.connectionReused);
+        assert(response.statusCode == 200 && response.timings.connectionReused);
+
+        // Without shared connections the pooled handles of blocking calls are warmed as well.
+        HttpClient pooled;
+        assert(pooled.warmup(origins)[0]);
+        const HttpResponse pooled_response = pooled.get("https://httpbin.org/get");
+        std::cout << std::format("First pooled request reused a warm connection: {}\n\n", pooled_response.timings.connectionReused);
+        assert(pooled_response.statusCode == 200 && pooled_response.timings.connectionReused);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Warmup' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests requests from several threads, taking turns, on a client that shares its connection cache between threads.
+ */
+void test_shared_connections() {
+    std::cout << "--- Shared Connections ---\n";
+
+    HttpClientConfig config;
+    config.shareConnections = true;
+    const HttpClient client(config);
+    // libcurl does not support concurrent use of a shared connection cache, so the calls never overlap.
+    std::mutex turn;
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&client, &turn, i]() {
+                try {
+                    for (int j = 0; j < 3; ++j) {
+                        std::scoped_lock lock(turn);
+                        auto response = client.get(std::format("https://httpbin.org/get?thread={}&request={}", i, j));
+                        assert(response.statusCode == 200);
+                    }
+                } catch (const CurlException& e) {
+                    std::cerr << std::format("Thread {} caught an exception: {}\n", i, e.what());
+                }
+            });
+        }
+    }
+
+    std::cout << "Shared connections test completed.\n\n";
+}
+
+/**
+ * @brief Tests asynchronous requests driven by the client's event loop.
+ */
+void test_async_requests() {
+    try {
+        const HttpClient client;
+        std::vector<std::future<HttpResponse>> futures;
+        const int num_requests = 10;
+        for (int i = 0; i < num_requests; ++i) {
+            futures.push_back(client.getAsync(std::format("https://httpbin.org/get?async={}", i)));
+        }
+        std::promise<long> callback_status;
+        client.postAsync("https://httpbin.org/post", R"({"async": true})",
+                         [&callback_status](std::expected<HttpResponse, CurlError> result) {
+                             callback_status.set_value(result ? result->statusCode : -1L);
+                         },
+                         {{"Content-Type", "application/json"}});
+
+        std::cout << "--- Async Requests ---\n";
+        for (int i = 0; i < num_requests; ++i) {
+            HttpResponse response = futures[i].get();
+            assert(response.statusCode == 200);
+            assert(response.body.find(std::format("async={}", i)) != std::string::npos);
+        }
+        assert(callback_status.get_future().get() == 200);
+        std::cout << std::format("{} futures and one callback completed successfully.\n\n", num_requests);
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Async Requests' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests priority classes, the in-flight limit and queue deadlines of sharded event loops.
+ */
+void test_priority_scheduler() {
+    try {
+        HttpClientConfig config;
+        config.scheduler.maxInFlight = 2;
+        config.scheduler.loopThreads = 2;
+        config.scheduler.queueDeadlines[static_cast<std::size_t>(HttpPriority::Bulk)] = std::chrono::milliseconds(200);
+        const HttpClient client(config);
+
+        // Each loop runs one transfer at a time, so these occupy both slots for two seconds.
+        std::vector<std::future<HttpResponse>> blockers;
+        blockers.push_back(client.getAsync("https://httpbin.org/delay/2"));
+        blockers.push_back(client.getAsync("https://httpbin.org/delay/2"));
+        std::vector<std::future<HttpResponse>> critical;
+        std::vector<std::future<HttpResponse>> bulk;
+        for (int i = 0; i < 4; ++i) {
+            critical.push_back(client.getAsync(std::format("https://httpbin.org/get?critical={}", i), {}, HttpPriority::Critical));
+            bulk.push_back(client.getAsync(std::format("https://httpbin.org/get?bulk={}", i), {}, HttpPriority::Bulk));
+        }
+
+        std::cout << "--- Priority Scheduler ---\n";
+        int dropped = 0;
+        for (auto& future : bulk) {
+            try {
+                static_cast<void>(future.get());
+            } catch (const CurlException&) {
+                ++dropped;
+            }
+        }
+        assert(dropped == 4);
+        for (auto& future : critical) {
+            assert(future.get().statusCode == 200);
+        }
+        for (auto& future : blockers) {
+            assert(future.get().statusCode == 200);
+        }
+        std::cout << "Critical requests waited for a slot; bulk requests were dropped after their queue deadline.\n\n";
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Priority Scheduler' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests an upload stream that a producer thread writes into while the chunked request is sent.
+ */
+void test_streaming_upload() {
+    try {
+        const HttpClient client;
+        // A small buffer makes the producer wait for the network, and its pauses make the upload wait for the producer.
+        HttpUploadStream stream(1024);
+        std::future<HttpResponse> future = client.postAsync("https://httpbin.org/post", stream, {{"Content-Type", "text/plain"}});
+        std::jthread producer([&stream] {
+            for (int i = 0; i < 200; ++i) {
+                if (!stream.write(std::format("log line {}\n", i))) return;
+                if (i % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            stream.close();
+        });
+        HttpResponse response = future.get();
+        assert(response.statusCode == 200);
+        assert(response.body.find("log line 199") != std::string::npos);
+        std::cout << "--- Streaming Upload ---\nChunked upload of 200 lines from a producer thread succeeded.\n\n";
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Streaming Upload' failed: {}\n", e.what());
+    }
+}
+
+/**
+ * @brief Tests that a batch keeps results in request order and reports failures per request.
+ */
+void test_batch_requests() {
+    HttpClientConfig config;
+    config.connectTimeoutMs = 2000L;
+    const HttpClient client(config);
+    std::vector<HttpRequest> requests;
+    const int num_gets = 5;
+    for (int i = 0; i < num_gets; ++i) {
+        requests.push_back({HttpMethod::Get, std::format("https://httpbin.org/get?batch={}", i), {}, {}, {}});
+    }
+    requests.push_back({HttpMethod::Post, "https://httpbin.org/post", {{"Content-Type", "application/json"}}, R"({"batch": true})", {}});
+    requests.push_back({HttpMethod::Get, "https://192.0.2.1/test", {}, {}, {}});
+
+    const auto results = client.batch(requests);
+    std::cout << "--- Batch Requests ---\n";
+    assert(results.size() == requests.size());
+    for (int i = 0; i < num_gets; ++i) {
+        if (!results[i]) {
+            std::cerr << std::format("Batch request {} failed: {}\n", i, results[i].error().message);
+            continue;
+        }
+        assert(results[i]->statusCode == 200);
+        assert(results[i]->body.find(std::format("batch={}", i)) != std::string::npos);
+    }
+    assert(results[num_gets] && results[num_gets]->body.find("\"batch\": true") != std::string::npos);
+    assert(!results[num_gets + 1]);
+    std::cout << std::format("Unreachable host reported per request: {}\n\n", results[num_gets + 1].error().message);
+}
+
+/**
+ * @brief Tests HTTP/2 over TLS with concurrent batch requests multiplexed on one connection.
+ */
+void test_http2_multiplexing() {
+    HttpClientConfig config;
+    config.httpVersion = HttpVersion::Http2Tls;
+    config.batchMaxHostConnections = 1L;
+    const HttpClient client(config);
+    const std::vector<HttpRequest> requests(5, HttpRequest{HttpMethod::Get, "https://httpbin.org/get", {}, {}, {}});
+
+    std::cout << "--- HTTP/2 Multiplexing ---\n";
+    int succeeded = 0;
+    for (const auto& result : client.batch(requests)) {
+        if (result && result->statusCode == 200) {
+            ++succeeded;
+        } else if (!result) {
+            std::cerr << std::format("HTTP/2 request failed: {}\n", result.error().message);
+        }
+    }
+    std::cout << std::format("{} of {} multiplexed requests succeeded.\n\n", succeeded, requests.size());
+    assert(succeeded == static_cast<int>(requests.size()));
+}
+
+/**
+ * @brief Minimal eagerly started coroutine type used to exercise the awaitable API.
+ */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Coroutine body for test_coroutine_requests.
+ * @param client The client to issue the requests with.
+ * @param done Fulfilled with the number of successful checks once the coroutine finishes.
+ */
+DetachedTask run_coroutine_requests(const HttpClient& client, std::promise<int>& done) {
+    int passed = 0;
+    try {
+        HttpResponse response = co_await client.coGet("https://httpbin.org/get?coroutine=1");
+        if (response.statusCode == 200 && response.body.find("coroutine=1") != std::string::npos) ++passed;
+
+        const std::map<std::string, std::string, std::less<>> headers = {{"Content-Type", "application/json"}};
+        std::string post_body = R"({"coroutine": true})";
+        response = co_await client.coPost("https://httpbin.org/post", std::move(post_body), headers);
+        if (response.statusCode == 200 && response.body.find("\"coroutine\": true") != std::string::npos) ++passed;
+    } catch (const CurlException& e) {
+        std::cerr << std::format("Test 'Coroutine Requests' failed: {}\n", e.what());
+    }
+    try {
+        (void)co_await client.coGet("https://192.0.2.1/test");
+    } catch (const CurlException&) {
+        ++passed;
+    }
+    done.set_value(passed);
+}
+
+/**
+ * @brief Tests the co_await request API, including exception propagation.
+ */
+void test_coroutine_requests() {
+    HttpClientConfig config;
+    config.connectTimeoutMs = 2000L;
+    const HttpClient client(config);
+    std::promise<int> done;
+    run_coroutine_requests(client, done);
+    const int passed = done.get_future().get();
+    std::cout << "--- Coroutine Requests ---\n";
+    std::cout << std::format("{} of 3 coroutine checks passed.\n\n", passed);
+    assert(passed == 3);
+}
+
 /**
  * @brief Main entry point for the test application.
  * @return 0 on successful execution.
@@ -207,12 +1059,40 @@ void test_thread_safety() {
 int main() {
     test_simple_get();
     test_get_with_headers();
+    test_response_headers();
+    test_response_timings();
+    test_metrics();
+    test_response_cache();
+    test_prepared_headers();
+    test_reused_response();
     test_simple_post();
+    test_zero_copy_post();
+    test_compression();
     test_multipart_post();
+    test_streaming_multipart_post();
+    test_streaming_get();
+    test_max_body_bytes();
+    test_segmented_download();
     test_connection_failure();
+    test_try_requests();
+    test_unix_socket();
     test_timeout();
+    test_retries();
+    test_circuit_breaker();
     test_invalid_certificate();
+    test_tls_settings();
+    test_handle_reuse();
     test_thread_safety();
+    test_host_limits();
+    test_single_flight();
+    test_warmup();
+    test_shared_connections();
+    test_async_requests();
+    test_priority_scheduler();
+    test_streaming_upload();
+    test_coroutine_requests();
+    test_batch_requests();
+    test_http2_multiplexing();
 
     std::cout << "All tests finished.\n";
     return 0;